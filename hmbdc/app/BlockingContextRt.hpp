@@ -6,6 +6,7 @@
 #include "hmbdc/time/Timers.hpp"
 #include "hmbdc/time/Time.hpp"
 #include "hmbdc/pattern/BlockingBufferRt.hpp"
+#include "hmbdc/pattern/BlockingBuffer.hpp"
 #include "hmbdc/os/Thread.hpp"
 #include "hmbdc/MetaUtils.hpp"
 #include "hmbdc/Exception.hpp"
@@ -22,6 +23,21 @@
 namespace hmbdc { namespace app {
 namespace blocking_context_rt_detail {
 HMBDC_CLASS_HAS_DECLARE(hmbdc_ctx_queued_ts);
+HMBDC_CLASS_HAS_DECLARE(hmbdc_conflate_key);
+
+template <typename Message>
+void putInPlace(pattern::BlockingBufferRt& buffer
+    , pattern::BlockingBufferRt::PushedOutBytesHandler const& handlePushedOut
+    , Message&& m) {
+    using M = typename std::decay<Message>::type;
+    if constexpr (has_hmbdc_conflate_key<M>::value) {
+        pattern::BlockingBufferRt::ConflationKey key{m.getTypeTag(), (uint64_t)m.hmbdc_conflate_key};
+        buffer.template putInPlaceConflated<MessageWrap<M>>(
+            handlePushedOut, key, std::forward<Message>(m));
+    } else {
+        buffer.template putInPlace<MessageWrap<M>>(handlePushedOut, std::forward<Message>(m));
+    }
+}
 
 template <typename Interests>
 struct RealInterests {
@@ -204,6 +220,11 @@ struct TransportEntry<JustBytes> {
  * - When a Clinet's msg queue is full, new msg arriving would NOT block the sender, instead it pushes 
  * the oldest message out from the queue and they are intentionally 'lost'. This is desired in real time
  * applications that only need the latest messages and do not ever want the sender to be blocked
+ * - When a Message type has a data member named hmbdc_conflate_key (an integer such as an instrument id),
+ * sending it conflates: a pending (not yet handled) message of the same type and key is replaced
+ * in place by the newer one, keeping its position in the queue. A slow Client always sees
+ * the latest value per key and a rarely updated key is not pushed out by a hot one.
+ * send() and justBytes delivery conflate; sendInPlace(), trySend() and send(range) do not
  * @details a Client running in such a BlockingContextRt utilizing OS's blocking mechanism
  * and takes less CPU time. The Client's responding time scales better when the number of 
  * Clients greatly exceeds the availlable CPUs in the system and the effective message rate
@@ -356,7 +377,7 @@ public:
     bool runOnce(ClientRegisterHandle& t, CcClient& c
         , time::Duration maxBlockingTime = time::Duration::seconds(1)) {
         std::atomic<bool> stopped = false;
-        return runOnceImpl(stopped, &t->buffer, c, maxBlockingTime);
+        return blocking_context_rt_detail::runOnceImpl(stopped, &t->buffer, c, maxBlockingTime);
     }
 
     /**
@@ -470,10 +491,11 @@ public:
                     }
 
                     if (i == entries.size() - 1) {
-                        e.transport->buffer
-                            .template putInPlace<MessageWrap<M>>(IgnorePushedOut{}, std::forward<Message>(m));
+                        blocking_context_rt_detail::putInPlace(e.transport->buffer
+                            , IgnorePushedOut{}, std::forward<Message>(m));
                     } else {
-                        e.transport->buffer.template putInPlace<MessageWrap<M>>(IgnorePushedOut{}, m);
+                        blocking_context_rt_detail::putInPlace(e.transport->buffer
+                            , IgnorePushedOut{}, m);
                     }
                 }
             }
@@ -819,7 +841,8 @@ private:
                 auto& e = entries[i];
                 if (e.transport->buffer.maxItemSize() >= sizeof(MessageWrap<M>)) {
                     if (e.deliverPred(m.getTypeTag(), (uint8_t*)&m)) {
-                        e.transport->buffer.template putInPlace<MessageWrap<M>>(IgnorePushedOut{}, m);
+                        blocking_context_rt_detail::putInPlace(e.transport->buffer
+                            , IgnorePushedOut{}, m);
                     }
                 } else {
                     HMBDC_THROW(std::out_of_range
@@ -20,7 +20,8 @@ struct InBandMemoryAttachmentProcessor {
     : att(new(underlyingMessage) hasMemoryAttachment){}
     uint8_t underlyingMessage[MAX_MEMORY_ATTACHMENT];
     template <MessageC Message>
-    bool cache(InBandHasMemoryAttachment<Message> const& ibma, uint16_t typeTagIn) {
+    bool cache(InBandHasMemoryAttachment<Message> const& ibma, uint16_t typeTagIn
+        , bool attInShm = false) {
         static_assert(sizeof(Message) <= MAX_MEMORY_ATTACHMENT, "");
         if (hmbdc_unlikely(att->attachment)) {
             HMBDC_THROW(std::logic_error, "previous InBandMemoryAttachment not concluded");
@@ -39,6 +40,20 @@ struct InBandMemoryAttachmentProcessor {
             att->afterConsumedCleanupFunc = nullptr;
             accSize = 0;
             return true;
+        } else if (attInShm) {
+            att->attachment = hmbdcShmHandleToAddr(att->shmHandle);
+            att->clientData[0] = (uint64_t)&hmbdcShmDeallocator;
+            att->afterConsumedCleanupFunc = [](hasMemoryAttachment* h) {
+                auto hmbdc0cpyShmRefCount 
+                    = reinterpret_cast<std::atomic<size_t>*>(h->attachment) - 1;
+                if (h->attachment && 1 == hmbdc0cpyShmRefCount->fetch_sub(1)) {
+                    auto& hmbdcShmDeallocator
+                        = *(std::function<void (uint8_t*)>*)h->clientData[0];
+                    hmbdcShmDeallocator((uint8_t*)h->attachment);
+                }
+            };
+            accSize = att->len;
+            return true;
         } else {
             att->attachment = malloc(att->len);
             att->afterConsumedCleanupFunc = hasMemoryAttachment::free;
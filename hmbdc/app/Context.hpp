@@ -6,6 +6,7 @@
 #include "hmbdc/Config.hpp"
 #include "hmbdc/numeric/BitMath.hpp"
 #include "hmbdc/time/Time.hpp"
+#include "hmbdc/os/ShmSizeClassHeap.hpp"
 
 #include <boost/interprocess/allocators/allocator.hpp>
 #include <memory>
@@ -620,6 +621,58 @@ struct ThreadCommBase
         return std::shared_ptr<uint8_t[]>{};
     }
 
+    /**
+     * @brief send a hasMemoryAttachment message to the attached ipc Contexts with its
+     * attachment copied into the shm attachment pool
+     * @details only the message holding the shm handle goes through the buffer - instead of
+     * the attachment bytes in InBandMemorySeg trains. Each of the readers releases the
+     * attachment once and the last one gives it back to the pool.
+     * The message's attachment is released once sent.
+     * This function is threadsafe, which means you can call it anywhere in the code
+     *
+     * @param m message
+     * @param readers how many ipc parties are to receive and release it
+     * @return false if the pool has no room for it now - nothing is sent
+     */
+    template <MessageC Message>
+    bool sendAttInShm(Message&& m, size_t readers) {
+        return sendAttInShmImpl(std::forward<Message>(m), readers, false);
+    }
+
+    /**
+     * @brief non blocking version of sendAttInShm
+     * @return false if the buffer or the pool has no room for it now - nothing is sent
+     */
+    template <MessageC Message>
+    bool trySendAttInShm(Message&& m, size_t readers) {
+        return sendAttInShmImpl(std::forward<Message>(m), readers, true);
+    }
+
+    /**
+     * @brief the sendJustBytesInPlace version of sendAttInShm
+     * @return false if the pool has no room for it now - nothing is sent
+     */
+    template <typename JustBytesType, typename ... Args>
+    bool sendJustBytesAttInShmInPlace(uint16_t tag, void const* bytes, size_t len
+        , app::hasMemoryAttachment* att, size_t readers, Args&& ...args) {
+        static_assert(cpa::ipc && !cpa::dev_mem, "no shm");
+        if (hmbdc_unlikely(len > maxMessageSize())) {
+            HMBDC_THROW(std::out_of_range, "message too big, typeTag=" << tag
+                << " len=" << len);
+        }
+        auto shmAddr = copyAttToShm(*att, readers);
+        if (!shmAddr) return false;
+        auto it = buffer_.claim();
+        auto wrap = new (*it) MessageWrap<InBandHasMemoryAttachment<JustBytesType>>(
+            tag, bytes, len, att, std::forward<Args>(args)...);
+        wrap->typeTag = InBandShmAttachment::typeTag;
+        reinterpret_cast<hasMemoryAttachment*>(wrap->payload.underlyingMessage.bytes)->shmHandle
+            = shmAttAllocator_->getHandle(shmAddr);
+        buffer_.commit(it);
+        att->release();
+        return true;
+    }
+
 protected:
     template <typename IntLvOrRv>
     ThreadCommBase(uint32_t messageQueueSizePower2Num
@@ -656,19 +709,13 @@ protected:
             size_t retry = 3;
             while (true) {
                 try {
-                    boost::interprocess::permissions perms(0660);
                     auto name = std::string(shmName) + "-att-pool";
                     if (ownership > 0) {
                         shm_unlink(name.c_str());
-                        shmAttAllocator_.emplace(
-                            ownership > 0, boost::interprocess::create_only
-                            , name.c_str(), ipcShmForAttPoolSize, nullptr, perms);
-                    } else {
-                        shmAttAllocator_.emplace(ownership > 0
-                            , boost::interprocess::open_only, name.c_str());
                     }
+                    shmAttAllocator_.emplace(ownership > 0, name.c_str(), ipcShmForAttPoolSize);
                     return;
-                } catch (boost::interprocess::interprocess_exception const&) {
+                } catch (std::runtime_error const&) {
                     if (--retry == 0) throw;
                     sleep(1);
                 }
@@ -724,9 +771,12 @@ protected:
             hmbdc0cpyShmRefCountSize = sizeof(size_t),
         };
 
-        template <typename Arg, typename ...Args>
-        ShmAttAllocator(bool own, Arg&& arg, char const* name, Args&& ... args)
-        : managedShm_(std::forward<Arg>(arg), name, std::forward<Args>(args)...) {
+        /**
+         * @brief ctor
+         * @param own create the shm (and unlink it at the end) or open the one created by the owner
+         */
+        ShmAttAllocator(bool own, char const* name, size_t size)
+        : heap_(name, size, own) {
             if (own) {
                 nameUnlink_ = name;
             }
@@ -740,12 +790,13 @@ protected:
 
         boost::interprocess::managed_shared_memory::handle_t
         getHandle(void* localAddr) const {
-            return managedShm_.get_handle_from_address((uint8_t*)localAddr - hmbdc0cpyShmRefCountSize);
+            return (boost::interprocess::managed_shared_memory::handle_t)
+                heap_.toOffset((uint8_t*)localAddr - hmbdc0cpyShmRefCountSize);
         }
 
         uint8_t*
         getAddr(boost::interprocess::managed_shared_memory::handle_t h) const {
-            return (uint8_t*)managedShm_.get_address_from_handle(h) + hmbdc0cpyShmRefCountSize;
+            return (uint8_t*)heap_.fromOffset((uint64_t)h) + hmbdc0cpyShmRefCountSize;
         }
        
         static std::atomic<size_t>& getHmbdc0cpyShmRefCount(void* attached) {
@@ -756,10 +807,15 @@ protected:
         
         uint8_t* allocate(size_t len) {
             auto res = (uint8_t*)nullptr;
-            len += hmbdc0cpyShmRefCountSize;
-            while (!(res = (uint8_t*)managedShm_.allocate(len, std::nothrow))) {
+            while (!(res = tryAllocate(len))) { //used up - wait for the readers
                 std::this_thread::yield();
             };
+            return res;
+        }
+
+        uint8_t* tryAllocate(size_t len) {
+            auto res = (uint8_t*)heap_.allocate(len + hmbdc0cpyShmRefCountSize);
+            if (!res) return nullptr;
             *(size_t*)res = 1;  /// prime the ref count
             // HMBDC_LOG_N(getHandle(res));
             return res + hmbdc0cpyShmRefCountSize;
@@ -767,15 +823,58 @@ protected:
 
         auto deallocate(uint8_t* p) {
             // HMBDC_LOG_N(getHandle(p));
-            return managedShm_.deallocate(p - hmbdc0cpyShmRefCountSize);
+            return heap_.deallocate(p - hmbdc0cpyShmRefCountSize);
         }
 
         private:
-        boost::interprocess::managed_shared_memory managedShm_;
+        os::ShmSizeClassHeap heap_;
         std::string nameUnlink_;
     };
     std::optional<ShmAttAllocator> shmAttAllocator_;
 
+    /**
+     * @brief copy the attachment into the shm pool, to be released by that many readers
+     * @return nullptr if no pool or no room in it now
+     */
+    uint8_t* copyAttToShm(hasMemoryAttachment const& att, size_t readers) {
+        if (!shmAttAllocator_ || !att.len || !readers) return nullptr;
+        auto shmAddr = shmAttAllocator_->tryAllocate(att.len);
+        if (shmAddr) {
+            memcpy(shmAddr, att.attachment, att.len);
+            ShmAttAllocator::getHmbdc0cpyShmRefCount(shmAddr).store(
+                readers, std::memory_order_relaxed); /// published by the buffer commit
+        }
+        return shmAddr;
+    }
+
+    template <MessageC Message>
+    bool sendAttInShmImpl(Message&& m, size_t readers, bool tryOnly) {
+        using M = typename std::decay<Message>::type;
+        static_assert(std::is_base_of<hasMemoryAttachment, M>::value, "");
+        static_assert(cpa::ipc && !cpa::dev_mem, "no shm");
+        if (hmbdc_unlikely(MAX_MESSAGE_SIZE == 0 
+            && sizeof(MessageWrap<InBandHasMemoryAttachment<M>>) > buffer_.maxItemSize())) {
+            HMBDC_THROW(std::out_of_range, "message too big, typeTag=" << m.getTypeTag());
+        }
+        auto shmAddr = copyAttToShm(m, readers);
+        if (!shmAddr) return false;
+        auto it = tryOnly ? buffer_.tryClaim(1) : buffer_.claim(1);
+        if (!it) {
+            shmAttAllocator_->deallocate(shmAddr);
+            return false;
+        }
+        auto wrap = (new (*it) MessageWrap<InBandHasMemoryAttachment<M>>(m));
+        wrap->typeTag = InBandShmAttachment::typeTag;
+        static_cast<hasMemoryAttachment&>(wrap->payload.underlyingMessage).shmHandle
+            = shmAttAllocator_->getHandle(shmAddr);
+        if constexpr (has_hmbdc_ctx_queued_ts<M>::value) {
+            wrap->template get<Message>().hmbdc_ctx_queued_ts = hmbdc::time::SysTime::now();
+        }
+        buffer_.commit(it, 1);
+        m.hasMemoryAttachment::release();
+        return true;
+    }
+
 private:
 
     template <typename M, typename... Messages>
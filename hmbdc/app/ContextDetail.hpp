@@ -180,7 +180,10 @@ bool runOnceImpl(uint16_t threadSerialNumber, std::atomic<bool> const& stopped
         using Cc = typename std::decay<CcClient>::type;
         const bool clientParticipateInMessaging = Cc::INTERESTS_SIZE != 0;
         if (clientParticipateInMessaging) {
-            uint64_t count = lfb.peek(begin, end, c.maxBatchMessageCount());
+            /// consumers of a partition claim adaptive sized batches, see MemRingBuffer<0>
+            static thread_local hmbdc::pattern::MonoLockFreeBuffer::AdaptiveBatch batch;
+            batch.max = c.maxBatchMessageCount();
+            uint64_t count = lfb.peek(begin, end, batch);
             c.invokedCb(c.handleRangeImpl(begin, end, threadSerialNumber));
             lfb.wasteAfterPeek(begin, count);
         } else {
@@ -144,6 +144,8 @@ struct alignas(8) hasMemoryAttachment {
 
     /**
      * @brief file mapped memory
+     * @details the file stays open till the attachment is released, so the network 
+     * transports can send it straight from the file - see mappedFileFd()
      * @param fileName file name to map
      */
     hasMemoryAttachment(char const* fileName) 
@@ -201,6 +203,14 @@ struct alignas(8) hasMemoryAttachment {
                                                         ///     ((SP*)h->clientData)->~SP();
                                                         /// };
 
+    /**
+     * @brief the fd of the file the attachment maps
+     * @return -1 if the attachment is not file mapped by map()
+     */
+    int mappedFileFd() const {
+        return afterConsumedCleanupFunc == hasMemoryAttachment::unmap ? (int)clientData[0] : -1;
+    }
+
     static void unmap(hasMemoryAttachment*);
     static void free(hasMemoryAttachment*);
     size_t map(char const* fileName);
@@ -487,6 +497,15 @@ struct InBandMemorySeg
 };
 #pragma pack(pop)
 
+/**
+ * @class InBandShmAttachment
+ * @brief tag of an InBandHasMemoryAttachment whose attachment is copied into the ipc shm
+ * attachment pool - it holds the shm handle and no InBandMemorySeg follows
+ */
+struct InBandShmAttachment
+: hasTag<9> {
+};
+
 template<MessageC Message>
 struct MessageWrap<InBandHasMemoryAttachment<Message>> :  MessageHead {
     template <typename ...Args>
@@ -554,9 +573,10 @@ map(char const* fileName) {
     len = (size_t)sb.st_size;
     attachment = mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
     if (attachment == MAP_FAILED) {
+        if (fd >= 0) close(fd);
         HMBDC_THROW(std::runtime_error, "map failed for " << fileName);
     } 
-    close(fd);
+    clientData[0] = (uint64_t)fd; //closed in unmap
     afterConsumedCleanupFunc = hasMemoryAttachment::unmap;
     return len;
 }
@@ -574,6 +594,7 @@ void
 hasMemoryAttachment::
 unmap(hasMemoryAttachment* a) {
     munmap(a->attachment, a->len);
+    close((int)a->clientData[0]);
     a->attachment = nullptr;
 }
 }} //hmbdc::app
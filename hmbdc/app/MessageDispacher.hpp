@@ -92,7 +92,8 @@ struct dispatcher {
                     } else {
                         return true;
                     }
-                } else if (m.typeTag == InBandHasMemoryAttachment<Flush>::typeTag) {
+                } else if (m.typeTag == InBandHasMemoryAttachment<Flush>::typeTag
+                    || m.typeTag == InBandShmAttachment::typeTag) {
                     auto underlyTag = m.scratchpad().ipc.hd.inbandUnderlyingTypeTag;
                     if (typeTagMatch<Message>((uint16_t)underlyTag)) {
                         auto& ibma = m.get<InBandHasMemoryAttachment<Message>>();
@@ -102,7 +103,8 @@ struct dispatcher {
                             }
                         }
                         
-                        if (ibmaproc.cache(ibma, underlyTag)) {
+                        if (ibmaproc.cache(ibma, underlyTag
+                            , m.typeTag == InBandShmAttachment::typeTag)) {
                             auto* msg = reinterpret_cast<Message*>(ibmaproc.underlyingMessage);(void)msg;
                             if constexpr (has_hmbdcName<CcClient>::value) {
                                 HMBDC_LOG_r(c.hmbdcName(), " (", this, ") <=== ", *msg);
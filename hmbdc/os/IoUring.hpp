@@ -0,0 +1,222 @@
+#include "hmbdc/Copyright.hpp"
+#pragma once
+
+#include "hmbdc/Exception.hpp"
+#include "hmbdc/Compile.hpp"
+
+#include <atomic>
+#include <algorithm>
+#include <stdexcept>
+#include <cstddef>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <string.h>
+#include <unistd.h>
+
+namespace hmbdc { namespace os {
+/**
+ * @brief a minimal single threaded io_uring - talks to the kernel directly, no liburing needed
+ * @details submission and completion go through the shared rings, the only system call is
+ * io_uring_enter in submit(), which is skipped when there is nothing for the kernel to do.
+ * Optionally one group of provided buffers (a registered buffer ring) is kept for
+ * buffer selecting receives such as a multishot recv.
+ * Needs linux 6.0+ for multishot recv over a buffer ring.
+ */
+struct IoUring {
+    /**
+     * @brief ctor
+     *
+     * @param entries submission queue size, the completion queue is twice as big
+     */
+    IoUring(unsigned entries) {
+        io_uring_params p;
+        memset(&p, 0, sizeof(p));
+        /// completions only get posted when this thread enters the kernel,
+        /// IORING_SQ_TASKRUN tells when that is needed
+        p.flags = IORING_SETUP_COOP_TASKRUN | IORING_SETUP_TASKRUN_FLAG;
+        fd_ = (int)syscall(__NR_io_uring_setup, entries, &p);
+        if (fd_ < 0 && errno == EINVAL) { //older kernel
+            memset(&p, 0, sizeof(p));
+            fd_ = (int)syscall(__NR_io_uring_setup, entries, &p);
+        }
+        if (fd_ < 0) {
+            HMBDC_THROW(std::runtime_error, "io_uring_setup failed, errno=" << errno);
+        }
+        if (!(p.features & IORING_FEAT_SINGLE_MMAP)) {
+            close(fd_);
+            HMBDC_THROW(std::runtime_error, "io_uring too old, needs IORING_FEAT_SINGLE_MMAP");
+        }
+        ringSize_ = std::max(p.sq_off.array + p.sq_entries * sizeof(unsigned)
+            , p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe));
+        ring_ = (char*)mmap(nullptr, ringSize_, PROT_READ | PROT_WRITE
+            , MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+        sqesSize_ = p.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = (io_uring_sqe*)mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE
+            , MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES);
+        if (ring_ == MAP_FAILED || sqes_ == MAP_FAILED) {
+            auto err = errno;
+            if (ring_ != MAP_FAILED) munmap(ring_, ringSize_);
+            if (sqes_ != MAP_FAILED) munmap(sqes_, sqesSize_);
+            close(fd_);
+            HMBDC_THROW(std::runtime_error, "io_uring mmap failed, errno=" << err);
+        }
+        sqHead_ = (std::atomic<unsigned>*)(ring_ + p.sq_off.head);
+        sqTail_ = (std::atomic<unsigned>*)(ring_ + p.sq_off.tail);
+        sqFlags_ = (std::atomic<unsigned>*)(ring_ + p.sq_off.flags);
+        sqMask_ = *(unsigned*)(ring_ + p.sq_off.ring_mask);
+        sqEntries_ = p.sq_entries;
+        auto array = (unsigned*)(ring_ + p.sq_off.array);
+        for (auto i = 0u; i < sqEntries_; ++i) array[i] = i; //sqes are always used in order
+        cqHead_ = (std::atomic<unsigned>*)(ring_ + p.cq_off.head);
+        cqTail_ = (std::atomic<unsigned>*)(ring_ + p.cq_off.tail);
+        cqMask_ = *(unsigned*)(ring_ + p.cq_off.ring_mask);
+        cqes_ = (io_uring_cqe*)(ring_ + p.cq_off.cqes);
+        sqeTail_ = submitted_ = sqTail_->load(std::memory_order_relaxed);
+    }
+
+    IoUring(IoUring const&) = delete;
+    IoUring& operator = (IoUring const&) = delete;
+    ~IoUring() {
+        if (bufRing_) munmap(bufRing_, bufRingSize_);
+        munmap(sqes_, sqesSize_);
+        munmap(ring_, ringSize_);
+        close(fd_);
+    }
+
+    /**
+     * @brief next zeroed sqe to fill in
+     * @return nullptr if the submission queue is full - submit() first
+     */
+    io_uring_sqe* getSqe() {
+        if (hmbdc_unlikely(sqeTail_ - sqHead_->load(std::memory_order_acquire) >= sqEntries_)) {
+            return nullptr;
+        }
+        auto res = &sqes_[sqeTail_++ & sqMask_];
+        memset(res, 0, sizeof(*res));
+        return res;
+    }
+
+    /**
+     * @brief hand the filled in sqes to the kernel and let it post the pending completions
+     * @details the io_uring_enter system call is only made when there are new sqes,
+     * pending kernel side work or waitNr is not 0
+     *
+     * @param waitNr block till that many completions are available
+     * @return number of sqes submitted, -1 with errno set for error
+     */
+    int submit(unsigned waitNr = 0) {
+        auto toSubmit = sqeTail_ - submitted_;
+        unsigned flags = 0;
+        if (waitNr || (sqFlags_->load(std::memory_order_relaxed) 
+            & (IORING_SQ_TASKRUN | IORING_SQ_CQ_OVERFLOW))) {
+            flags |= IORING_ENTER_GETEVENTS;
+        } else if (!toSubmit) {
+            return 0;
+        }
+        sqTail_->store(sqeTail_, std::memory_order_release);
+        auto res = (int)syscall(__NR_io_uring_enter, fd_, toSubmit, waitNr, flags, nullptr, 0);
+        if (res > 0) submitted_ += res;
+        return res;
+    }
+
+    /**
+     * @brief call f(io_uring_cqe const&) on each available completion and consume them
+     * @return number of completions consumed
+     */
+    template <typename F>
+    unsigned reap(F&& f) {
+        auto head = cqHead_->load(std::memory_order_relaxed);
+        auto tail = cqTail_->load(std::memory_order_acquire);
+        for (auto i = head; i != tail; ++i) {
+            f(cqes_[i & cqMask_]);
+        }
+        cqHead_->store(tail, std::memory_order_release);
+        return tail - head;
+    }
+
+    /**
+     * @brief register a ring of count buffers of bufSize bytes each, starting at bufs,
+     * the kernel picks from them for sqes with IOSQE_BUFFER_SELECT and buf_group of bgid
+     * @details the buffer id of a buffer is its index, and it is handed to the kernel
+     * right away. The memory is not owned.
+     *
+     * @param count power of 2, up to 32768
+     */
+    void provideBuffers(uint16_t bgid, char* bufs, unsigned count, unsigned bufSize) {
+        bufRingSize_ = count * sizeof(io_uring_buf);
+        bufRing_ = (io_uring_buf*)mmap(nullptr, bufRingSize_, PROT_READ | PROT_WRITE
+            , MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+        if (bufRing_ == MAP_FAILED) {
+            bufRing_ = nullptr;
+            HMBDC_THROW(std::runtime_error, "buffer ring mmap failed, errno=" << errno);
+        }
+        io_uring_buf_reg reg;
+        memset(&reg, 0, sizeof(reg));
+        reg.ring_addr = (uint64_t)bufRing_;
+        reg.ring_entries = count;
+        reg.bgid = bgid;
+        if (syscall(__NR_io_uring_register, fd_, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+            HMBDC_THROW(std::runtime_error, "IORING_REGISTER_PBUF_RING failed, errno=" << errno);
+        }
+        /// the tail overlays the reserved field of the first entry
+        bufRingTail_ = (std::atomic<uint16_t>*)((char*)bufRing_
+            + offsetof(io_uring_buf, resv));
+        bufRingMask_ = count - 1;
+        bufs_ = bufs;
+        bufSize_ = bufSize;
+        for (auto i = 0u; i < count; ++i) {
+            recycleBuffer((uint16_t)i);
+        }
+    }
+
+    /**
+     * @brief the buffer a buffer selecting completion filled
+     */
+    char* buffer(io_uring_cqe const& cqe) const {
+        return bufs_ + size_t(cqe.flags >> IORING_CQE_BUFFER_SHIFT) * bufSize_;
+    }
+
+    /**
+     * @brief give a provided buffer back to the kernel once done with it
+     */
+    void recycleBuffer(uint16_t bid) {
+        auto tail = bufRingTail_->load(std::memory_order_relaxed);
+        auto& b = bufRing_[tail & bufRingMask_];
+        b.addr = (uint64_t)(bufs_ + size_t(bid) * bufSize_);
+        b.len = bufSize_;
+        b.bid = bid;
+        bufRingTail_->store(tail + 1, std::memory_order_release);
+    }
+
+    void recycleBuffer(io_uring_cqe const& cqe) {
+        recycleBuffer(uint16_t(cqe.flags >> IORING_CQE_BUFFER_SHIFT));
+    }
+
+private:
+    int fd_;
+    char* ring_;
+    size_t ringSize_;
+    io_uring_sqe* sqes_;
+    size_t sqesSize_;
+    std::atomic<unsigned>* sqHead_;
+    std::atomic<unsigned>* sqTail_;
+    std::atomic<unsigned>* sqFlags_;
+    unsigned sqMask_;
+    unsigned sqEntries_;
+    unsigned sqeTail_; /// sqes handed out by getSqe()
+    unsigned submitted_; /// sqes taken by the kernel
+    std::atomic<unsigned>* cqHead_;
+    std::atomic<unsigned>* cqTail_;
+    unsigned cqMask_;
+    io_uring_cqe* cqes_;
+
+    io_uring_buf* bufRing_ = nullptr;
+    size_t bufRingSize_ = 0;
+    std::atomic<uint16_t>* bufRingTail_ = nullptr;
+    unsigned bufRingMask_ = 0;
+    char* bufs_ = nullptr;
+    unsigned bufSize_ = 0;
+};
+}}
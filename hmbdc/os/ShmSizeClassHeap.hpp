@@ -0,0 +1,179 @@
+#include "hmbdc/Copyright.hpp"
+#pragma once
+
+#include "hmbdc/Exception.hpp"
+#include "hmbdc/Compile.hpp"
+
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <cstdint>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace hmbdc { namespace os {
+/**
+ * @brief a lock free heap living in a named shared memory, for processes to allocate
+ * from and free into concurrently
+ * @details blocks are power of 2 sized (64B and up) and are referred to by offsets, so
+ * each process can map the shm at a different address. A freed block goes on the lock free
+ * free list of its size class - blocks are never split or merged; a fresh block is carved
+ * from the untouched end of the shm, and when that runs out a free block of a bigger size
+ * class is used. Every allocate or deallocate is a few compare-and-swaps on the shm.
+ */
+struct ShmSizeClassHeap {
+    enum {
+        MinBlockSizePower2 = 6,
+        ClassCount = 40,
+    };
+
+    /**
+     * @brief ctor
+     *
+     * @param name shm name
+     * @param size shm size in bytes when create, not used otherwise
+     * @param create create (replacing any existing) the shm or open the existing one
+     * @param perms permissions for a created shm
+     */
+    ShmSizeClassHeap(char const* name, size_t size, bool create, mode_t perms = 0660) {
+        auto fd = create
+            ? shm_open(name, O_CREAT | O_EXCL | O_RDWR, perms)
+            : shm_open(name, O_RDWR, 0);
+        if (fd < 0) {
+            HMBDC_THROW(std::runtime_error, "shm_open failed for " << name << " errno=" << errno);
+        }
+        struct stat st;
+        if ((create && (fchmod(fd, perms) < 0 || ftruncate(fd, (off_t)size) < 0))
+            || fstat(fd, &st) < 0 || size_t(st.st_size) <= sizeof(Head)) {
+            auto err = errno;
+            close(fd);
+            HMBDC_THROW(std::runtime_error, "shm not ready " << name << " errno=" << err);
+        }
+        size_ = (size_t)st.st_size;
+        base_ = (char*)mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (base_ == MAP_FAILED) {
+            HMBDC_THROW(std::runtime_error, "mmap failed for " << name << " errno=" << errno);
+        }
+        head_ = reinterpret_cast<Head*>(base_);
+        if (create) {
+            head_->size = size_;
+            head_->top.store(sizeof(Head), std::memory_order_relaxed);
+            for (auto& l : head_->freeLists) l.store(0, std::memory_order_relaxed);
+            head_->magic.store(Magic, std::memory_order_release);
+        } else if (head_->magic.load(std::memory_order_acquire) != Magic) {
+            munmap(base_, size_);
+            HMBDC_THROW(std::runtime_error, "shm not initialized yet " << name);
+        }
+    }
+
+    ShmSizeClassHeap(ShmSizeClassHeap const&) = delete;
+    ShmSizeClassHeap& operator = (ShmSizeClassHeap const&) = delete;
+    ~ShmSizeClassHeap() {
+        munmap(base_, size_);
+    }
+
+    /**
+     * @brief allocate len bytes, 16 bytes aligned
+     * @return nullptr if the shm is used up for now
+     */
+    void* allocate(size_t len) {
+        auto need = len + sizeof(BlockHead);
+        auto c = 0u;
+        while (c < ClassCount && blockSize(c) < need) ++c;
+        if (hmbdc_unlikely(c == ClassCount)) return nullptr;
+        auto b = pop(c);
+        if (hmbdc_likely(!b)) {
+            auto top = head_->top.load(std::memory_order_relaxed);
+            do {
+                if (top + blockSize(c) > size_) break;
+            } while (!head_->top.compare_exchange_weak(top, top + blockSize(c)
+                , std::memory_order_relaxed));
+            if (top + blockSize(c) <= size_) {
+                b = reinterpret_cast<BlockHead*>(base_ + top);
+                b->sizeClass = c;
+            } else {
+                for (auto bc = c + 1; !b && bc < ClassCount; ++bc) {
+                    b = pop(bc);
+                }
+            }
+        }
+        return b ? b + 1 : nullptr;
+    }
+
+    /**
+     * @brief give back what allocate() returns - by any process mapping the shm
+     */
+    void deallocate(void* p) {
+        auto b = static_cast<BlockHead*>(p) - 1;
+        auto& list = head_->freeLists[b->sizeClass];
+        auto idx = index(b);
+        auto h = list.load(std::memory_order_relaxed);
+        do {
+            b->next.store(h & IndexMask, std::memory_order_relaxed);
+        } while (!list.compare_exchange_weak(h, ((h & ~IndexMask) + TagOne) | idx
+            , std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    /**
+     * @brief position independent reference to an address in the shm
+     */
+    uint64_t toOffset(void const* p) const {
+        return uint64_t(static_cast<char const*>(p) - base_);
+    }
+
+    void* fromOffset(uint64_t offset) const {
+        return base_ + offset;
+    }
+
+private:
+    enum : uint64_t {
+        Magic = 0x68736361706865ul,
+        IndexBits = 40,
+        IndexMask = (1ul << IndexBits) - 1, /// block index in MinBlockSize units, 0 for none
+        TagOne = 1ul << IndexBits,          /// aba tag in the high bits
+    };
+
+    struct alignas(16) BlockHead {
+        uint32_t sizeClass;
+        std::atomic<uint64_t> next; /// free list link, only meaningful when free
+    };
+    static_assert(sizeof(BlockHead) == 16);
+
+    struct alignas(64) Head {
+        std::atomic<uint64_t> magic;
+        uint64_t size;
+        std::atomic<uint64_t> top;      /// untouched from here
+        std::atomic<uint64_t> freeLists[ClassCount];
+    };
+
+    static constexpr size_t blockSize(uint32_t c) {
+        return size_t(1) << (c + MinBlockSizePower2);
+    }
+
+    uint64_t index(BlockHead const* b) const {
+        return toOffset(b) >> MinBlockSizePower2;
+    }
+
+    BlockHead* pop(uint32_t c) {
+        auto& list = head_->freeLists[c];
+        auto h = list.load(std::memory_order_acquire);
+        while (h & IndexMask) {
+            auto b = reinterpret_cast<BlockHead*>(base_ + ((h & IndexMask) << MinBlockSizePower2));
+            auto next = b->next.load(std::memory_order_relaxed); //maybe stale - the tag catches it
+            if (list.compare_exchange_weak(h, ((h & ~IndexMask) + TagOne) | next
+                , std::memory_order_acquire, std::memory_order_acquire)) {
+                return b;
+            }
+        }
+        return nullptr;
+    }
+
+    char* base_;
+    size_t size_;
+    Head* head_;
+};
+}}
@@ -0,0 +1,217 @@
+#include "hmbdc/Copyright.hpp"
+#pragma once
+
+#include "hmbdc/Exception.hpp"
+#include "hmbdc/Compile.hpp"
+
+#include <atomic>
+#include <new>
+#include <stdexcept>
+#include <cstdlib>
+#include <cstdint>
+
+namespace hmbdc { namespace os {
+
+namespace sizeclassallocator_detail {
+/**
+ * @brief precedes every block handed out
+ */
+struct alignas(16) BlockHead {
+    void* owner;        /// the thread cache the block goes back to
+    BlockHead* next;    /// free list link
+    uint32_t sizeClass;
+    bool inSlab;        /// carved from a slab - never given back to the system
+};
+
+/**
+ * @class SizeClassAllocator<>
+ * @brief process wide thread caching allocator for power of 2 size classes
+ * @details each thread allocates from its own cache - no atomic operation when there is a
+ * free block of the size class. A block freed by another thread is pushed (lock free)
+ * to a remote list of the owning cache and taken back in the next time the owner runs out
+ * of that size class. Blocks smaller than SlabBytes are carved out of slabs of SlabBytes, which
+ * are kept for the life of the process, the bigger ones are allocated one by one and a cache
+ * keeps up to CachedBytesPerClass of them for each size class.
+ * Sizes above 2^MaxSizePower2 bypass the caches. A cache of an exited thread is adopted by
+ * the next new thread.
+ *
+ * @tparam MinSizePower2 the smallest size class is 2^MinSizePower2 bytes
+ * @tparam MaxSizePower2 the largest size class is 2^MaxSizePower2 bytes
+ * @tparam SlabBytes see above
+ * @tparam CachedBytesPerClass see above
+ */
+template <unsigned MinSizePower2 = 6
+    , unsigned MaxSizePower2 = 30
+    , size_t SlabBytes = 1024 * 1024
+    , size_t CachedBytesPerClass = 64 * 1024 * 1024>
+struct SizeClassAllocator {
+    enum {
+        ClassCount = MaxSizePower2 - MinSizePower2 + 1,
+        Large = ClassCount, /// not cached
+    };
+    static_assert(MinSizePower2 >= 4 && MinSizePower2 <= MaxSizePower2 && MaxSizePower2 < 48);
+
+    /**
+     * @brief allocate size bytes, 16 bytes aligned
+     * @return never nullptr - throws std::bad_alloc
+     */
+    static void* allocate(size_t size) {
+        auto c = sizeClass(size);
+        auto cache = threadCache();
+        if (hmbdc_unlikely(c == Large || !cache)) {
+            return newBlock(nullptr, Large, size, false) + 1;
+        }
+        auto& list = cache->freeList[c];
+        if (hmbdc_unlikely(!list)) {
+            cache->collectRemote();
+        }
+        if (hmbdc_unlikely(!list)) {
+            cache->refill(c);
+        }
+        auto b = list;
+        list = b->next;
+        if (!b->inSlab) cache->cachedBytes[c] -= classSize(c);
+        return b + 1;
+    }
+
+    /**
+     * @brief give back what allocate() returns - from any thread
+     */
+    static void deallocate(void* p) {
+        if (!p) return;
+        auto b = static_cast<BlockHead*>(p) - 1;
+        if (hmbdc_unlikely(b->sizeClass == Large)) {
+            ::free(b);
+            return;
+        }
+        auto cache = threadCache();
+        auto owner = static_cast<Cache*>(b->owner);
+        if (hmbdc_likely(cache == owner)) {
+            cache->put(b);
+        } else {
+            auto h = owner->remote.load(std::memory_order_relaxed);
+            do {
+                b->next = h;
+            } while (!owner->remote.compare_exchange_weak(h, b
+                , std::memory_order_release, std::memory_order_relaxed));
+        }
+    }
+
+private:
+    static constexpr size_t classSize(uint32_t c) {
+        return size_t(1) << (c + MinSizePower2);
+    }
+
+    static uint32_t sizeClass(size_t size) {
+        if (size <= classSize(0)) return 0;
+        auto p2 = 64u - (unsigned)__builtin_clzl(size - 1);
+        return p2 > MaxSizePower2 ? (uint32_t)Large : p2 - MinSizePower2;
+    }
+
+    static BlockHead* newBlock(void* owner, uint32_t c, size_t size, bool inSlab) {
+        auto b = static_cast<BlockHead*>(::malloc(sizeof(BlockHead) + size));
+        if (!b) throw std::bad_alloc();
+        b->owner = owner;
+        b->sizeClass = c;
+        b->inSlab = inSlab;
+        return b;
+    }
+
+    struct Cache {
+        BlockHead* freeList[ClassCount] = {nullptr};
+        size_t cachedBytes[ClassCount] = {0}; /// of the blocks not in slabs
+        std::atomic<BlockHead*> remote{nullptr};
+        std::atomic<bool> inUse{true};
+        Cache* nextCache = nullptr;
+
+        void put(BlockHead* b) {
+            auto c = b->sizeClass;
+            if (!b->inSlab) {
+                if (cachedBytes[c] + classSize(c) > CachedBytesPerClass && freeList[c]) {
+                    ::free(b);
+                    return;
+                }
+                cachedBytes[c] += classSize(c);
+            }
+            b->next = freeList[c];
+            freeList[c] = b;
+        }
+
+        void collectRemote() {
+            auto b = remote.exchange(nullptr, std::memory_order_acquire);
+            while (b) {
+                auto next = b->next;
+                put(b);
+                b = next;
+            }
+        }
+
+        void refill(uint32_t c) {
+            auto sz = sizeof(BlockHead) + classSize(c);
+            if (sz > SlabBytes) {
+                auto b = newBlock(this, c, classSize(c), false);
+                b->next = nullptr;
+                freeList[c] = b;
+                cachedBytes[c] += classSize(c);
+                return;
+            }
+            auto slab = static_cast<char*>(::malloc(SlabBytes));
+            if (!slab) throw std::bad_alloc();
+            for (auto p = slab; p + sz <= slab + SlabBytes; p += sz) {
+                auto b = reinterpret_cast<BlockHead*>(p);
+                b->owner = this;
+                b->sizeClass = c;
+                b->inSlab = true;
+                b->next = freeList[c];
+                freeList[c] = b;
+            }
+        }
+    };
+
+    /**
+     * @brief the calling thread's cache - adopts an abandoned one or makes a new one
+     * @return nullptr when the thread is exiting
+     */
+    static Cache* threadCache() {
+        static thread_local Cache* cache = nullptr;
+        static thread_local bool exited = false;
+        if (hmbdc_likely(cache)) return cache;
+        if (exited) return nullptr;
+        struct Holder {
+            ~Holder() {
+                cache->inUse.store(false, std::memory_order_release);
+                cache = nullptr;
+                exited = true;
+            }
+        };
+        for (auto c = caches_.load(std::memory_order_acquire); c; c = c->nextCache) {
+            auto inUse = false;
+            if (c->inUse.compare_exchange_strong(inUse, true, std::memory_order_acquire)) {
+                cache = c;
+                break;
+            }
+        }
+        if (!cache) {
+            cache = new Cache;
+            auto h = caches_.load(std::memory_order_relaxed);
+            do {
+                cache->nextCache = h;
+            } while (!caches_.compare_exchange_weak(h, cache
+                , std::memory_order_release, std::memory_order_relaxed));
+        }
+        static thread_local Holder holder;
+        (void)holder;
+        return cache;
+    }
+
+    inline static std::atomic<Cache*> caches_{nullptr}; /// all caches ever made, never deleted
+};
+} //sizeclassallocator_detail
+
+template <unsigned MinSizePower2 = 6
+    , unsigned MaxSizePower2 = 30
+    , size_t SlabBytes = 1024 * 1024
+    , size_t CachedBytesPerClass = 64 * 1024 * 1024>
+using SizeClassAllocator = sizeclassallocator_detail::SizeClassAllocator<
+    MinSizePower2, MaxSizePower2, SlabBytes, CachedBytesPerClass>;
+}}
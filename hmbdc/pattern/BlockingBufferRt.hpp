@@ -7,6 +7,9 @@
 #include <functional>
 #include <mutex>              // std::mutex, std::unique_lock
 #include <condition_variable> // std::condition_variable
+#include <unordered_map>
+#include <vector>
+#include <utility>
 #include <malloc.h>
 #include <assert.h>
 
@@ -25,8 +28,10 @@ public:
     : maxItemSize_(maxItemSize)
     , capacity_(capacity)
     , size_(0)
-    , seq_(0) {
+    , seq_(0)
+    , slotKeys_(capacity) {
         store_ = (char*)memalign(SMP_CACHE_BYTES, capacity*maxItemSize);
+        conflated_.reserve(capacity);
     }
 
     BlockingBufferRt(BlockingBufferRt const&) = delete;
@@ -48,7 +53,7 @@ public:
     void put(PushedOutBytesHandler handlePushedOut, void const* item, size_t sizeHint = 0) {
         std::unique_lock<std::mutex> lck(mutex_);
         if (capacity_ <= size_) {
-            handlePushedOut(getItem(seq_ - size_--));
+            pushOut(handlePushedOut);
         }
         memcpy(getItem(seq_++), item, sizeHint?sizeHint:maxItemSize_);
         if (++size_ == 1) {
@@ -62,7 +67,7 @@ public:
     put(PushedOutBytesHandler handlePushedOut, T&& item, Ts&&... items) {
         std::unique_lock<std::mutex> lck(mutex_);
         while (capacity_ <= size_ + sizeof...(Ts)) {
-            handlePushedOut(getItem(seq_ - size_--));
+            pushOut(handlePushedOut);
         }
         fill(std::forward<T>(item), std::forward<Ts>(items)...);
         size_ += sizeof...(items) + 1;
@@ -77,7 +82,7 @@ public:
     putBatch(PushedOutBytesHandler handlePushedOut, It begin, size_t n) {
         std::unique_lock<std::mutex> lck(mutex_);
         while (capacity_ <= size_ + n) {
-            handlePushedOut(getItem(seq_ - size_--));
+            pushOut(handlePushedOut);
         }
         fillBatch(begin, n);
         size_ += n;
@@ -92,7 +97,7 @@ public:
     putBatchInPlace(PushedOutBytesHandler handlePushedOut, It begin, size_t n) {
         std::unique_lock<std::mutex> lck(mutex_);
         while (capacity_ <= size_ + n) {
-            handlePushedOut(getItem(seq_ - size_--));
+            pushOut(handlePushedOut);
         }
         fillBatchInPlace<Item>(begin, n);
         size_ += n;
@@ -106,7 +111,7 @@ public:
     void putInPlace(PushedOutBytesHandler handlePushedOut, Args&&... args) {
         std::unique_lock<std::mutex> lck(mutex_);
         if (capacity_ <= size_) {
-            handlePushedOut(getItem(seq_ - size_--));
+            pushOut(handlePushedOut);
         }
         new (getItem(seq_++)) T(std::forward<Args>(args)...);
         if (++size_ == 1) {
@@ -115,6 +120,47 @@ public:
         }
     }
 
+    /**
+     * @brief the key identifying a conflatable item - typically (typeTag, instrument id)
+     */
+    using ConflationKey = std::pair<uint16_t, uint64_t>;
+
+    /**
+     * @brief put an item that replaces the pending (not yet taken) item having the same key
+     * @details the replacement happens in place so the position of the key in the FIFO
+     * is preserved - a slow consumer sees the latest value per key, in the order each
+     * key first became pending. The replaced item goes through handlePushedOut and is then destroyed.
+     * When there is no pending item for the key, it is the same as putInPlace.
+     * 
+     * @param handlePushedOut handles the replaced or pushed out (when full) item
+     * @param key conflation key
+     * @param args ctor args of T
+     */
+    template <typename T, typename ...Args>
+    void putInPlaceConflated(PushedOutBytesHandler handlePushedOut, ConflationKey key
+        , Args&&... args) {
+        std::unique_lock<std::mutex> lck(mutex_);
+        auto it = conflated_.find(key);
+        if (it != conflated_.end()) {
+            auto item = getItem(it->second);
+            handlePushedOut(item);
+            static_cast<T*>(item)->~T();
+            new (item) T(std::forward<Args>(args)...);
+            return;
+        }
+        if (capacity_ <= size_) {
+            pushOut(handlePushedOut);
+        }
+        auto seq = seq_++;
+        new (getItem(seq)) T(std::forward<Args>(args)...);
+        slotKeys_[seq % capacity_] = SlotKey{true, key};
+        conflated_.emplace(key, seq);
+        if (++size_ == 1) {
+            lck.unlock();
+            hasItem_.notify_all();
+        }
+    }
+
     template <typename T, typename ...Args>
     bool tryPutInPlace(Args&&... args) {
         std::unique_lock<std::mutex> lck(mutex_);
@@ -153,7 +199,7 @@ public:
         std::unique_lock<std::mutex> lck(mutex_);
         hasItem_.wait(lck, [this](){return size_;});
         coh(dest, getItem(seq_ - size_), sizeHint?sizeHint:maxItemSize_);
-        size_--;
+        forget(seq_ - size_--);
     }
 
     template <typename T>
@@ -167,7 +213,7 @@ public:
         std::unique_lock<std::mutex> lck(mutex_);
         if (!hasItem_.wait_for(lck, std::chrono::nanoseconds(timeout.nanoseconds()), [this](){return size_;})) return false;
         coh(dest, getItem(seq_ - size_), sizeHint?sizeHint:maxItemSize_);
-        size_--;
+        forget(seq_ - size_--);
         return true;
     }
 
@@ -182,7 +228,8 @@ public:
         hasItem_.wait(lck, [this](){return size_;});
         auto s = size_;
         while (s && b != e) {
-            coh(&*b++, getItem(seq_ - s--), std::min(maxItemSize_, sizeof(*b)));
+            coh(&*b++, getItem(seq_ - s), std::min(maxItemSize_, sizeof(*b)));
+            forget(seq_ - s--);
         }
         auto ret = size_ - s;
         size_ = s;
@@ -195,6 +242,8 @@ public:
     void reset() {
         size_ = 0;
         seq_ = 0;
+        conflated_.clear();
+        std::fill(slotKeys_.begin(), slotKeys_.end(), SlotKey{});
     }
 
     void waitItem(time::Duration timeout) {
@@ -203,6 +252,31 @@ public:
             , [this](){return size_;});
     }
 private:
+    struct SlotKey {
+        bool keyed = false;
+        ConflationKey key;
+    };
+    struct ConflationKeyHash {
+        size_t operator()(ConflationKey const& k) const {
+            return std::hash<uint64_t>()(k.second * 0x9e3779b97f4a7c15ul ^ k.first);
+        }
+    };
+
+    void forget(size_t seq) {
+        if (hmbdc_unlikely(!conflated_.empty())) {
+            auto& sk = slotKeys_[seq % capacity_];
+            if (sk.keyed) {
+                conflated_.erase(sk.key);
+                sk.keyed = false;
+            }
+        }
+    }
+
+    void pushOut(PushedOutBytesHandler& handlePushedOut) {
+        handlePushedOut(getItem(seq_ - size_));
+        forget(seq_ - size_--);
+    }
+
     void fill(){}
     template <typename T, typename... Ts> 
     void 
@@ -225,6 +299,8 @@ private:
     size_t seq_;
     std::mutex mutex_;
     std::condition_variable hasItem_;
+    std::vector<SlotKey> slotKeys_;
+    std::unordered_map<ConflationKey, size_t, ConflationKeyHash> conflated_;
 };
 
 namespace blocking_buffer_rt_detail {
@@ -10,6 +10,7 @@
 #include <stdexcept>
 #include <cstddef>
 #include <functional>
+#include <limits>
 #include <atomic>
 
 #include <stdint.h>
@@ -29,6 +30,16 @@ struct DeadConsumer : std::runtime_error {
     : std::runtime_error(what_arg){}
 };
 
+/**
+ * @brief per consumer state of the adaptive batch claiming
+ * @details k is how many slots a consumer claims in a single CAS, it grows when the
+ * backlog stays bigger than k and shrinks when the consumer finds less to do
+ */
+struct AdaptiveBatch {
+    size_t k = 1;
+    size_t max = std::numeric_limits<size_t>::max();
+};
+
 template <typename Seq>
 struct chunk_base_ptr {
     template<typename Allocator = os::DefaultAllocator>
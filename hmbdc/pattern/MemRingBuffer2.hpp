@@ -262,6 +262,33 @@ public:
         return end - begin;
     }
 
+    /**
+     * @brief peek with a batch size adapting to the backlog, for multiple consumers sharing
+     * the buffer
+     * @details each call claims up to batch.k slots in a single CAS on the read sequence.
+     * k doubles (up to batch.max) when the backlog left for the other consumers is still
+     * no less than k, and halves when fewer than k slots were found - so a busy buffer
+     * is drained with few CASes while an idle one is shared one slot at a time.
+     * Each slot is still claimed by exactly one consumer
+     * 
+     * @param begin output start
+     * @param end output end
+     * @param batch the calling consumer's own state
+     * @return size_t the number of slots claimed
+     */
+    size_t peek(iterator& begin, iterator& end, lf_misc::AdaptiveBatch& batch) HMBDC_RESTRICT {
+        auto res = peek(begin, end, batch.k);
+        if (res == batch.k) {
+            if (remainingSize() >= batch.k && batch.k < batch.max) {
+                batch.k = std::min(batch.k * 2, batch.max);
+            }
+        } else if (batch.k > 1) {
+            batch.k = std::max(batch.k / 2, res);
+            batch.k = std::max(batch.k, (size_t)1u);
+        }
+        return res;
+    }
+
     size_t peekSome(iterator& begin, iterator& end
         , size_t maxPeekSize = std::numeric_limits<size_t>::max()) {
         size_t res;
@@ -0,0 +1,362 @@
+#include "hmbdc/Copyright.hpp"
+#pragma once
+#include "hmbdc/pattern/MemRingBuffer.hpp"
+#include "hmbdc/Exception.hpp"
+#include "hmbdc/Compile.hpp"
+
+#include <string>
+#include <mutex>
+#include <atomic>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace hmbdc { namespace pattern {
+
+namespace memringbuffer_detail {
+/**
+ * @brief append only, memory mapped and segmented record of what a MemRingBuffer carried
+ * @details the journal is a series of files named <path>.<segment number>, each holding
+ * 2^segmentSizePower2Num fixed size slots - the same slot size as the ring buffer.
+ * A slot is located purely by arithmetic on its sequence number (segment = seq >> power,
+ * offset = seq & mask), so the sequence index is free and a replay from any sequence
+ * is a pointer walk over mapped memory.
+ * Each slot starts with (sequence + 1), written after the payload with release semantic -
+ * a zero (never written) or mismatching value marks the end of the committed journal.
+ * The journal sequence continues from where the previous process left off: on open the
+ * newest segment is scanned for the first uncommitted slot.
+ */
+struct MemRingBufferJournal {
+    using Sequence = HMBDC_SEQ_TYPE;
+
+    /**
+     * @brief open or create a journal
+     *
+     * @param path path prefix of the segment files, for example /var/tmp/myipc
+     * @param valueTypeSizePower2Num slot size power of 2, same as the ring buffer's
+     * @param segmentSizePower2Num how many slots in a segment file in power of 2
+     * @param readOnly only for replaying - no segment is ever created
+     */
+    MemRingBufferJournal(char const* path, uint32_t valueTypeSizePower2Num
+        , uint32_t segmentSizePower2Num, bool readOnly = false)
+    : path_(path)
+    , SLOT_SIZE(1ul << valueTypeSizePower2Num)
+    , VALUE_TYPE_SIZE(SLOT_SIZE - sizeof(Sequence))
+    , SEGMENT_SIZE_POWER2_NUM(segmentSizePower2Num)
+    , SEGMENT_MASK((1ul << segmentSizePower2Num) - 1)
+    , SEGMENT_BYTES(SLOT_SIZE << segmentSizePower2Num)
+    , readOnly_(readOnly)
+    , firstSeq_(0)
+    , nextSeq_(0) {
+        if (valueTypeSizePower2Num + segmentSizePower2Num > 40) {
+            HMBDC_THROW(std::out_of_range, "journal segment too big valueTypeSizePower2Num="
+                << valueTypeSizePower2Num << " segmentSizePower2Num=" << segmentSizePower2Num);
+        }
+        for (auto& s : segments_) {
+            s.no = std::numeric_limits<Sequence>::max();
+            s.addr = nullptr;
+        }
+        recover();
+    }
+
+    MemRingBufferJournal(MemRingBufferJournal const&) = delete;
+    MemRingBufferJournal& operator = (MemRingBufferJournal const&) = delete;
+
+    ~MemRingBufferJournal() {
+        for (auto& s : segments_) {
+            if (s.addr) munmap(s.addr, SEGMENT_BYTES);
+        }
+    }
+
+    /**
+     * @brief the oldest sequence still available in the journal files
+     */
+    Sequence firstSeq() const {
+        return firstSeq_;
+    }
+
+    /**
+     * @brief the journal sequence the next append is going to get when the journal is opened
+     * @details afterwards it does not change - use committedSeqEnd() for the live end
+     */
+    Sequence nextSeq() const {
+        return nextSeq_;
+    }
+
+    /**
+     * @brief copy a ring slot payload into the journal - thread safe
+     * @details concurrent appenders must have their sequences within
+     * 3 segments of each other, which is always true when the segment is not
+     * smaller than the ring buffer feeding it
+     *
+     * @param seq journal sequence
+     * @param payload points to VALUE_TYPE_SIZE bytes
+     */
+    void append(Sequence seq, void const* HMBDC_RESTRICT payload) HMBDC_RESTRICT {
+        auto slot = slotAddr(seq, true);
+        memcpy(slot + sizeof(Sequence), payload, VALUE_TYPE_SIZE);
+        reinterpret_cast<std::atomic<Sequence>*>(slot)->store(seq + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief replay the committed slots starting at a sequence
+     * @details replay stops at the first uncommitted slot, the end of the journal
+     * or when the callback returns false
+     *
+     * @param fromSeq the sequence to start from, needs to be no less than firstSeq()
+     * @param cb callback as bool(Sequence seq, void const* payload)
+     * @return the sequence right after the last replayed slot
+     */
+    template <typename Callback>
+    Sequence replay(Sequence fromSeq, Callback&& cb) {
+        if (fromSeq < firstSeq_) {
+            HMBDC_THROW(std::out_of_range, "journal starts at " << firstSeq_ << " cannot replay from " << fromSeq);
+        }
+        auto seq = fromSeq;
+        while (true) {
+            auto slot = slotAddr(seq, false);
+            if (!slot
+                || reinterpret_cast<std::atomic<Sequence>*>(slot)->load(std::memory_order_acquire)
+                    != seq + 1) {
+                break;
+            }
+            if (!cb(seq, (void const*)(slot + sizeof(Sequence)))) {
+                ++seq;
+                break;
+            }
+            ++seq;
+        }
+        return seq;
+    }
+
+    /**
+     * @brief remove the segment files that only contain sequences before a sequence
+     * @details do not call it when there are outstanding replays or appends to those segments
+     * @param seq the sequence, the segment containing it is kept
+     */
+    void retireBefore(Sequence seq) {
+        std::lock_guard<std::mutex> g(lock_);
+        auto keep = seq >> SEGMENT_SIZE_POWER2_NUM;
+        for (auto no = firstSeq_ >> SEGMENT_SIZE_POWER2_NUM; no < keep; ++no) {
+            auto& s = segments_[no % SEGMENT_WINDOW];
+            if (s.no == no) {
+                munmap(s.addr, SEGMENT_BYTES);
+                s.addr = nullptr;
+                reinterpret_cast<std::atomic<Sequence>&>(s.no).store(
+                    std::numeric_limits<Sequence>::max(), std::memory_order_release);
+            }
+            unlink(segmentName(no).c_str());
+        }
+        firstSeq_ = std::max(firstSeq_, keep << SEGMENT_SIZE_POWER2_NUM);
+    }
+
+    /**
+     * @brief flush the dirty pages of the mapped segments to the disk
+     * @details the mapped write already survives a process crash, this is only needed to
+     * survive a host crash
+     */
+    void sync() {
+        std::lock_guard<std::mutex> g(lock_);
+        for (auto& s : segments_) {
+            if (s.addr) msync(s.addr, SEGMENT_BYTES, MS_SYNC);
+        }
+    }
+
+private:
+    enum {
+        SEGMENT_WINDOW = 4,
+    };
+    struct Segment {
+        Sequence no;
+        char* addr;
+    };
+
+    std::string segmentName(Sequence no) const {
+        return path_ + "." + std::to_string(no);
+    }
+
+    char* slotAddr(Sequence seq, bool create) HMBDC_RESTRICT {
+        auto no = seq >> SEGMENT_SIZE_POWER2_NUM;
+        auto& s = segments_[no % SEGMENT_WINDOW];
+        if (hmbdc_unlikely(reinterpret_cast<std::atomic<Sequence>&>(s.no).load(
+            std::memory_order_acquire) != no)) {
+            if (!mapSegment(no, create)) return nullptr;
+        }
+        return s.addr + ((seq & SEGMENT_MASK) * SLOT_SIZE);
+    }
+
+    bool mapSegment(Sequence no, bool create) {
+        std::lock_guard<std::mutex> g(lock_);
+        auto& s = segments_[no % SEGMENT_WINDOW];
+        if (s.no == no) return true;
+        auto name = segmentName(no);
+        auto fd = open(name.c_str(), readOnly_ ? O_RDONLY : (O_RDWR | (create ? O_CREAT : 0)), 0660);
+        if (fd < 0) {
+            if (!create && errno == ENOENT) return false;
+            HMBDC_THROW(std::runtime_error, "cannot open journal segment " << name << " errno=" << errno);
+        }
+        if (!readOnly_ && ftruncate(fd, SEGMENT_BYTES)) {
+            close(fd);
+            HMBDC_THROW(std::runtime_error, "cannot size journal segment " << name << " errno=" << errno);
+        }
+        auto addr = mmap(NULL, SEGMENT_BYTES, readOnly_ ? PROT_READ : (PROT_READ | PROT_WRITE)
+            , MAP_SHARED, fd, 0);
+        close(fd);
+        if (addr == MAP_FAILED) {
+            HMBDC_THROW(std::runtime_error, "cannot map journal segment " << name << " errno=" << errno);
+        }
+        if (s.addr) munmap(s.addr, SEGMENT_BYTES);
+        s.addr = (char*)addr;
+        reinterpret_cast<std::atomic<Sequence>&>(s.no).store(no, std::memory_order_release);
+        return true;
+    }
+
+    void recover() {
+        auto slash = path_.rfind('/');
+        auto dirName = slash == std::string::npos ? std::string(".") : path_.substr(0, slash + 1);
+        auto prefix = (slash == std::string::npos ? path_ : path_.substr(slash + 1)) + ".";
+        auto dir = opendir(dirName.c_str());
+        if (!dir) {
+            HMBDC_THROW(std::runtime_error, "cannot open journal dir " << dirName << " errno=" << errno);
+        }
+        auto lowNo = std::numeric_limits<Sequence>::max();
+        auto highNo = std::numeric_limits<Sequence>::max();
+        while (auto ent = readdir(dir)) {
+            if (strncmp(ent->d_name, prefix.c_str(), prefix.size())) continue;
+            char* end;
+            auto no = strtoull(ent->d_name + prefix.size(), &end, 10);
+            if (*end || end == ent->d_name + prefix.size()) continue;
+            lowNo = lowNo == std::numeric_limits<Sequence>::max() ? no : std::min<Sequence>(lowNo, no);
+            highNo = highNo == std::numeric_limits<Sequence>::max() ? no : std::max<Sequence>(highNo, no);
+        }
+        closedir(dir);
+        if (lowNo == std::numeric_limits<Sequence>::max()) return;
+
+        firstSeq_ = lowNo << SEGMENT_SIZE_POWER2_NUM;
+        nextSeq_ = highNo << SEGMENT_SIZE_POWER2_NUM;
+        nextSeq_ = replay(nextSeq_, [](Sequence, void const*){return true;});
+    }
+
+    std::string const path_;
+public:
+    size_t const SLOT_SIZE;
+    size_t const VALUE_TYPE_SIZE;
+private:
+    uint32_t const SEGMENT_SIZE_POWER2_NUM;
+    Sequence const SEGMENT_MASK;
+    size_t const SEGMENT_BYTES;
+    bool const readOnly_;
+    Sequence firstSeq_;
+    Sequence nextSeq_;
+    std::mutex lock_;
+    Segment segments_[SEGMENT_WINDOW];
+};
+
+/**
+ * @brief a MemRingBuffer that also appends every committed slot into a MemRingBufferJournal
+ * @details the producer path has one extra memcpy into the mapped journal slot
+ * and nothing else - no syscall and no extra lock unless a new segment is rolled.
+ * The journal sequence is the ring sequence offset by where the journal left
+ * off when opened, so a restarted process keeps a gapless journal sequence.
+ * A restarted process could replay() from any journal sequence before rejoining live traffic.
+ *
+ * @tparam parallel_consumer_count see MemRingBuffer
+ */
+template<uint16_t parallel_consumer_count>
+class JournaledMemRingBuffer
+: public MemRingBuffer<parallel_consumer_count> {
+    using Base = MemRingBuffer<parallel_consumer_count>;
+public:
+    using Sequence = typename Base::Sequence;
+    using iterator = typename Base::iterator;
+
+    /**
+     * @brief ctor
+     *
+     * @param valueTypeSizePower2Num see MemRingBuffer
+     * @param ringSizePower2Num see MemRingBuffer
+     * @param journalPath path prefix of the journal segment files
+     * @param segmentSizePower2Num slots in a journal segment in power of 2,
+     * no less than ringSizePower2Num
+     * @param allocator see MemRingBuffer
+     */
+    template <typename Allocator = os::DefaultAllocator>
+    JournaledMemRingBuffer(uint32_t valueTypeSizePower2Num, uint32_t ringSizePower2Num
+        , char const* journalPath, uint32_t segmentSizePower2Num
+        , Allocator& allocator = os::DefaultAllocator::instance())
+    : Base(valueTypeSizePower2Num, ringSizePower2Num, allocator)
+    , journal_(journalPath, valueTypeSizePower2Num
+        , std::max(segmentSizePower2Num, ringSizePower2Num))
+    , journalSeqBase_(journal_.nextSeq()) {
+    }
+
+    void put(void const* HMBDC_RESTRICT item, size_t sizeHint = 0) HMBDC_RESTRICT {
+        auto it = Base::claim();
+        memcpy(*it, item, sizeHint ? sizeHint : this->VALUE_TYPE_SIZE);
+        commit(it);
+    }
+
+    bool tryPut(void const* HMBDC_RESTRICT item, size_t sizeHint = 0) HMBDC_RESTRICT {
+        auto it = Base::tryClaim();
+        if (!it) return false;
+        memcpy(*it, item, sizeHint ? sizeHint : this->VALUE_TYPE_SIZE);
+        commit(it);
+        return true;
+    }
+
+    void killPut(void const* HMBDC_RESTRICT item, size_t sizeHint = 0) HMBDC_RESTRICT {
+        auto it = Base::killClaim();
+        memcpy(*it, item, sizeHint ? sizeHint : this->VALUE_TYPE_SIZE);
+        commit(it);
+    }
+
+    void commit(iterator it) HMBDC_RESTRICT {
+        journal_.append(journalSeqBase_ + it.seq_, *it);
+        Base::commit(it);
+    }
+
+    void commit(iterator from, size_t n) HMBDC_RESTRICT {
+        auto it = from;
+        for (size_t i = 0; i < n; ++i, ++it) {
+            journal_.append(journalSeqBase_ + it.seq_, *it);
+        }
+        Base::commit(from, n);
+    }
+
+    /**
+     * @brief journal sequence of a ring slot
+     */
+    Sequence journalSeq(iterator it) const {
+        return journalSeqBase_ + it.seq_;
+    }
+
+    /**
+     * @brief see MemRingBufferJournal::replay
+     */
+    template <typename Callback>
+    Sequence replay(Sequence fromJournalSeq, Callback&& cb) {
+        return journal_.replay(fromJournalSeq, std::forward<Callback>(cb));
+    }
+
+    MemRingBufferJournal& journal() {
+        return journal_;
+    }
+
+private:
+    MemRingBufferJournal journal_;
+    Sequence const journalSeqBase_;
+};
+} //memringbuffer_detail
+
+using MemRingBufferJournal = memringbuffer_detail::MemRingBufferJournal;
+
+template<uint16_t PARALLEL_CONSUMER_COUNT>
+using JournaledMemRingBuffer = memringbuffer_detail::JournaledMemRingBuffer<PARALLEL_CONSUMER_COUNT>;
+}}
@@ -18,6 +18,7 @@ namespace hmbdc { namespace pattern {
     using iterator = hmbdc::pattern::lf_misc::iterator<Sequence>;
     using value_type = void *;
     using DeadConsumer = hmbdc::pattern::lf_misc::DeadConsumer;
+    using AdaptiveBatch = hmbdc::pattern::lf_misc::AdaptiveBatch;
     enum {
         max_parallel_consumer = 0xffff
     };
@@ -65,6 +66,7 @@ namespace hmbdc { namespace pattern {
     iterator peek();
     size_t peek(iterator&, iterator&
         , size_t maxPeekSize = std::numeric_limits<size_t>::max());
+    size_t peek(iterator&, iterator&, AdaptiveBatch&);
     size_t peekSome(iterator&, iterator&
         , size_t maxPeekSize = std::numeric_limits<size_t>::max());
     /**
@@ -159,6 +161,7 @@ inline void                        MonoLockFreeBuffer::take(void *i, size_t n)
 inline bool                        MonoLockFreeBuffer::tryTake(void *i, size_t n)                            	HMBDC_RESTRICT {return  static_cast<MMRB*>(impl_vptr)->tryTake(i, n);}
 inline MonoLockFreeBuffer::iterator    MonoLockFreeBuffer::peek()                                            	HMBDC_RESTRICT {return  static_cast<MMRB*>(impl_vptr)->peek();}
 inline size_t                      MonoLockFreeBuffer::peek(iterator& b, iterator& e, size_t s)              	HMBDC_RESTRICT {return  static_cast<MMRB*>(impl_vptr)->peek(b, e, s);}
+inline size_t                      MonoLockFreeBuffer::peek(iterator& b, iterator& e, AdaptiveBatch& ab)      	HMBDC_RESTRICT {return  static_cast<MMRB*>(impl_vptr)->peek(b, e, ab);}
 inline size_t                      MonoLockFreeBuffer::peekSome(iterator& b, iterator& e, size_t s)            HMBDC_RESTRICT {return  static_cast<MMRB*>(impl_vptr)->peekSome(b, e, s);}
 inline void                        MonoLockFreeBuffer::wasteAfterPeek(iterator b, size_t n, bool incomplete )	HMBDC_RESTRICT {        static_cast<MMRB*>(impl_vptr)->wasteAfterPeek(b, n, incomplete);}
 inline size_t                      MonoLockFreeBuffer::remainingSize() const                                 	HMBDC_RESTRICT {return  static_cast<MMRB*>(impl_vptr)->remainingSize();}
@@ -15,6 +15,7 @@ struct Rater {
     , currentLevel_()
     , previousCheck_()
     , enabled_(false)
+    , burst_()
     {}
 
     Rater(Duration duration, size_t times, size_t burst, bool enabled = true)
@@ -23,6 +24,7 @@ struct Rater {
     , currentLevel_(bucket_)
     , previousCheck_()
     , enabled_(enabled?times != 0:false)
+    , burst_(burst)
     {}
 
     bool check(size_t n = 1u) {
@@ -43,12 +45,25 @@ struct Rater {
         return enabled_;
     }
 
+    /**
+     * @brief change the rate on the fly, the burst stays the same number of times
+     * 
+     * @param duration the period
+     * @param times allowed times in the period, 0 is treated as 1
+     */
+    void setRate(Duration duration, size_t times) {
+        drop_ = duration / (times?times:1ul);
+        bucket_ = drop_ * burst_;
+        if (currentLevel_ > bucket_) currentLevel_ = bucket_;
+    }
+
 private:
     Duration drop_;
     Duration bucket_;
     Duration currentLevel_;
     SysTime  previousCheck_;
     bool enabled_;
+    size_t burst_;
     size_t n_;
 };
 }}
@@ -2,6 +2,7 @@
 #include "hmbdc/time/Time.hpp"
 #include "hmbdc/app/Config.hpp"
 #include "hmbdc/app/Message.hpp"
+#include "hmbdc/os/SizeClassAllocator.hpp"
 #include <iostream>
 #include <fstream>
 #include <atomic>
@@ -258,7 +259,7 @@ struct InputBag {
                 if (bmh.attLen != 0xfffffffffffffffful) {
                     att = new (bytes) app::hasMemoryAttachment;
                     att->len = bmh.attLen;
-                    att->attachment = malloc(sizeof(size_t) + att->len);
+                    att->attachment = os::SizeClassAllocator<>::allocate(sizeof(size_t) + att->len);
                     auto& refCount = *(size_t*)att->attachment;
                     refCount = 1;
                     att->clientData[0] = (uint64_t)&refCount;
@@ -268,7 +269,7 @@ struct InputBag {
                         if (0 == --*reinterpret_cast<std::atomic<size_t>*>(&refCount)) {
                             auto toFree = (char*)att->attachment;
                             toFree -= sizeof(size_t);
-                            ::free(toFree);
+                            os::SizeClassAllocator<>::deallocate(toFree);
                         }
                     };
 
@@ -0,0 +1,215 @@
+#include "hmbdc/Copyright.hpp"
+#pragma once
+#include "hmbdc/app/Message.hpp"
+#include "hmbdc/os/Allocators.hpp"
+#include "hmbdc/MetaUtils.hpp"
+#include "hmbdc/Exception.hpp"
+#include "hmbdc/Compile.hpp"
+#include "hmbdc/Config.hpp"
+
+#include <atomic>
+#include <optional>
+#include <type_traits>
+#include <stdexcept>
+#include <string.h>
+
+namespace hmbdc { namespace tips {
+
+namespace blackboard_detail {
+HMBDC_CLASS_HAS_DECLARE(hmbdc_conflate_key);
+
+struct Slot {
+    enum : uint32_t {
+        EMPTY = 0,
+        CLAIMING = 1,
+        READY = 2,
+    };
+    std::atomic<uint32_t> state;
+    uint16_t tag;
+    uint64_t key;
+    std::atomic<uint64_t> version; /// seqlock - odd when being written
+    uint32_t len;
+    alignas(8) uint8_t bytes[1];
+};
+
+struct Board {
+    size_t slotCount;
+    size_t slotSize;
+};
+
+template <typename Message>
+uint64_t keyOf(Message const& m) {
+    if constexpr (has_hmbdc_conflate_key<Message>::value) {
+        return (uint64_t)m.hmbdc_conflate_key;
+    } else {
+        return 0;
+    }
+}
+} //blackboard_detail
+
+/**
+ * @brief a shared memory latest-value store - one seqlock protected slot per (tag, key)
+ * @details publishers overwrite the slot, readers copy the latest value out when they want it.
+ * No reader takes a slot in the IPC ring buffer so the readers do not slow down
+ * the IPC transport no matter how infrequently they read.
+ * The key of a Message is its hmbdc_conflate_key data member if it has one, or 0 otherwise.
+ * Slots are allocated on first write by open addressing and never freed.
+ * Thread and process safe for multiple writers and readers.
+ */
+struct Blackboard {
+    using Slot = blackboard_detail::Slot;
+    using Board = blackboard_detail::Board;
+
+    /**
+     * @brief the shm size needed
+     *
+     * @param slotCount max number of (tag, key) pairs
+     * @param maxItemSize max bytes of an item
+     * @return size_t in bytes
+     */
+    static size_t footprint(size_t slotCount, size_t maxItemSize) {
+        auto res = SMP_CACHE_BYTES + slotCount * slotSizeFor(maxItemSize);
+        auto pageSize = (size_t)getpagesize();
+        return (res + pageSize - 1) / pageSize * pageSize;
+    }
+
+    /**
+     * @brief create or attach to a Blackboard in shm
+     *
+     * @param name shm name
+     * @param slotCount max number of (tag, key) pairs
+     * @param maxItemSize max bytes of an item
+     * @param ownership see os::ShmBasePtrAllocator
+     */
+    Blackboard(char const* name, size_t slotCount, size_t maxItemSize, int ownership)
+    : allocator_(name, 0, footprint(slotCount, maxItemSize), ownership)
+    , board_(allocator_.template allocate<Board>(SMP_CACHE_BYTES)) {
+        auto slotSize = slotSizeFor(maxItemSize);
+        if (ownership > 0) {
+            board_->slotCount = slotCount;
+            board_->slotSize = slotSize;
+        } else if (board_->slotCount != slotCount || board_->slotSize != slotSize) {
+            HMBDC_THROW(std::runtime_error, "Blackboard " << name << " exists with different size");
+        }
+        slots_ = (char*)board_ + SMP_CACHE_BYTES;
+    }
+
+    Blackboard(Blackboard const&) = delete;
+    Blackboard& operator = (Blackboard const&) = delete;
+
+    size_t maxItemSize() const {
+        return board_->slotSize - offsetof(Slot, bytes);
+    }
+
+    /**
+     * @brief write the latest value of (tag, key)
+     * @details throws when the board is full or the item is too big
+     */
+    void write(uint16_t tag, uint64_t key, void const* bytes, size_t len) {
+        if (hmbdc_unlikely(len > maxItemSize())) {
+            HMBDC_THROW(std::out_of_range, "Blackboard item too big " << len);
+        }
+        auto& s = *find(tag, key, true);
+        auto v = s.version.load(std::memory_order_relaxed);
+        while ((v & 1)
+            || !s.version.compare_exchange_weak(v, v + 1, std::memory_order_acquire)) {
+            v = s.version.load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+        s.len = (uint32_t)len;
+        memcpy(s.bytes, bytes, len);
+        s.version.store(v + 2, std::memory_order_release);
+    }
+
+    /**
+     * @brief copy out the latest value of (tag, key)
+     *
+     * @param bytes output buffer
+     * @param len output buffer size, the value is truncated if the buffer is smaller
+     * @return the version of the value copied out - 0 if the (tag, key) was never written
+     */
+    uint64_t read(uint16_t tag, uint64_t key, void* bytes, size_t len) const {
+        auto ps = find(tag, key, false);
+        if (!ps) return 0;
+        auto& s = *ps;
+        while (true) {
+            auto v = s.version.load(std::memory_order_acquire);
+            if (hmbdc_unlikely(v & 1)) continue;
+            memcpy(bytes, s.bytes, std::min<size_t>(len, s.len));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (hmbdc_likely(s.version.load(std::memory_order_relaxed) == v)) {
+                return v / 2;
+            }
+        }
+    }
+
+    /**
+     * @brief the version of (tag, key) - increases by 1 on each write, 0 if never written
+     * @details cheap way for readers to poll for changes before copying out
+     */
+    uint64_t version(uint16_t tag, uint64_t key) const {
+        auto ps = find(tag, key, false);
+        return ps ? ps->version.load(std::memory_order_acquire) / 2 : 0;
+    }
+
+    template <app::MessageC Message>
+    void write(Message const& m) {
+        static_assert(std::is_trivially_copyable<Message>::value, "cannot put in shm");
+        write(m.getTypeTag(), blackboard_detail::keyOf(m), &m, sizeof(m));
+    }
+
+    /**
+     * @brief read a Message's latest value
+     *
+     * @param m output - for a Message having typeTag range, its tag needs to be set already
+     * @param key the hmbdc_conflate_key value of the Message
+     * @return see read above
+     */
+    template <app::MessageC Message>
+    uint64_t read(Message& m, uint64_t key = 0) const {
+        static_assert(std::is_trivially_copyable<Message>::value, "cannot put in shm");
+        return read(m.getTypeTag(), key, &m, sizeof(m));
+    }
+
+private:
+    static size_t slotSizeFor(size_t maxItemSize) {
+        auto res = offsetof(Slot, bytes) + maxItemSize;
+        return (res + SMP_CACHE_BYTES - 1) / SMP_CACHE_BYTES * SMP_CACHE_BYTES;
+    }
+
+    Slot* slot(size_t i) const {
+        return reinterpret_cast<Slot*>(slots_ + i * board_->slotSize);
+    }
+
+    Slot* find(uint16_t tag, uint64_t key, bool create) const {
+        auto count = board_->slotCount;
+        auto h = (key * 0x9e3779b97f4a7c15ul) ^ (uint64_t(tag) * 0xff51afd7ed558ccdul);
+        for (size_t n = 0; n < count; ++n) {
+            auto& s = *slot((h + n) % count);
+            auto state = s.state.load(std::memory_order_acquire);
+            if (state == Slot::EMPTY) {
+                if (!create) return nullptr;
+                if (s.state.compare_exchange_strong(state, Slot::CLAIMING
+                    , std::memory_order_acquire)) {
+                    s.tag = tag;
+                    s.key = key;
+                    s.state.store(Slot::READY, std::memory_order_release);
+                    return &s;
+                }
+            }
+            while (state == Slot::CLAIMING) {
+                state = s.state.load(std::memory_order_acquire);
+            }
+            if (s.tag == tag && s.key == key) return &s;
+        }
+        if (create) {
+            HMBDC_THROW(std::out_of_range, "Blackboard is full, slotCount=" << count);
+        }
+        return nullptr;
+    }
+
+    os::ShmBasePtrAllocator allocator_;
+    Board* board_;
+    char* slots_;
+};
+}}
@@ -13,6 +13,8 @@ constexpr char const*  const DefaultUserConfig = R"|(
     "ipcTransportOwnership"         : "optional",       "__ipcTransportOwnership"           : "the shm of the IPC transport is owned by a single Domain object per domain per host (the first Domain object gets constructed) - when this Domain is destroyed, the IPC shm is destroyed. This setting is to coordinate the Domain creation. 'optional': this Domain is either creating the shm IPC transport or attach to the existing one; 'own': must recreate and own; 'attach': only attach to existing one.",
     "ipcPurgeIntervalSeconds"       : 0,                "__ipcPurgeIntervalSeconds"         : "if not 0, a purger is to run to remove dead or stagnant IPC party so other parties are not impacted. This is the period of doing the purge",
     "ipcShmForAttPoolSize"          : 134217728,        "__ipcShmForAttPoolSize"            : "large IPCable message or 0cpy messages could use this shm pool to pass around the attachment. This is the pool size in bytes.",
+    "ipcAttInShmMinBytes"           : 65536,            "__ipcAttInShmMinBytes"             : "a memory attachment of at least this many bytes going to other processes is copied into the ipcShmForAttPoolSize pool once and only its handle goes through the IPC transport, as if it were a 0cpy message - 0 turns it off",
+    "ipcBlackboardSlotCount"        : 0,                "__ipcBlackboardSlotCount"          : "if not 0, a shm blackboard holding the latest value per (tag, hmbdc_conflate_key) is created alongside the IPC transport. It is the max number of (tag, key) pairs. See Domain::publishLatest() and Domain::readLatest()",
     "netMaxMessageSizeRuntime"      : 1000,             "__netMaxMessageSizeRuntime"        : "if not listed in code's (==0), use this as network transport's buffer width in bytes",
     "pumpHmbdcName"                 : "tipspump",       "__pumpHmbdcName"                   : "pump thread uses this as thread name",
     "pumpConfigs"                   : [{}],             "__pumpConfigs"                     : ["an array, each element (captured in a {}) maps to a pump, and contains the configs for the pump, for example each rmcast transport's multicast address etc. Messages are handled by one and only one of the pumps depending on its tag value. Default value is single pump with default configs"],
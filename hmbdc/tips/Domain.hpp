@@ -1,6 +1,7 @@
 #include "hmbdc/Copyright.hpp"
 #pragma once
 #include "hmbdc/tips/DefaultUserConfig.hpp"
+#include "hmbdc/tips/Blackboard.hpp"
 #include "hmbdc/tips/Messages.hpp"
 #include "hmbdc/tips/TypeTagSet.hpp"
 #include "hmbdc/app/BlockingContext.hpp"
@@ -13,6 +14,7 @@
 #include "hmbdc/time/Timers.hpp"
 #include "hmbdc/Exception.hpp"
 #include "hmbdc/pattern/GuardedSingleton.hpp"
+#include "hmbdc/os/SizeClassAllocator.hpp"
 #include "hmbdc/MetaUtils.hpp"
 
 #include <deque>
@@ -317,6 +319,27 @@ struct DefaultAttachmentAllocator {
     }
 };
 
+/**
+ * @brief a drop-in replacement of DefaultAttachmentAllocator that takes the attachment memory
+ * from power of 2 size classes cached per thread - see os::SizeClassAllocator
+ * @details suits a steady flow of attachments: allocating in the pump thread and releasing
+ * in the Node threads neither locks nor goes to the heap once the caches are warm
+ */
+struct PooledAttachmentAllocator {
+    using Pool = os::SizeClassAllocator<>;
+    /**
+     * @brief see DefaultAttachmentAllocator
+     */
+    void* operator()(uint16_t typeTag, app::hasMemoryAttachment* att) {
+        att->attachment = Pool::allocate(att->len);
+        att->afterConsumedCleanupFunc = [](app::hasMemoryAttachment* hasAtt) {
+            Pool::deallocate(hasAtt->attachment);
+            hasAtt->attachment = nullptr;
+        };
+        return att->attachment;
+    }
+};
+
 /**
  * @brief Messages published on a TIPS pub/sub domain reach all the Nodes
  * within that domain based on their subscriptions.
@@ -397,6 +420,7 @@ private:
             , os::ShmBasePtrAllocator>
     > allocator_;
     TypeTagSet* pOutboundSubscriptions_ = nullptr;
+    std::optional<Blackboard> blackboard_;
 
     struct OneBuffer {
         ThreadCtx& threadCtx;
@@ -670,7 +694,8 @@ private:
         AttachmentAllocator attAllocator;
         
         template <app::MessageC Message>
-        bool cache(app::InBandHasMemoryAttachment<Message> const& ibma, uint16_t typeTagIn) {
+        bool cache(app::InBandHasMemoryAttachment<Message> const& ibma, uint16_t typeTagIn
+            , bool attInShm = false) {
             static_assert(sizeof(Message) <= MAX_MEMORY_ATTACHMENT, "");
             if (hmbdc_unlikely(att->attachment)) {
                 HMBDC_THROW(std::logic_error, "previous InBandMemoryAttachment not concluded");
@@ -705,6 +730,21 @@ private:
                     accSize = att->len;
                 } /// no else
                 return true;
+            } else if (attInShm) {
+                /// promoted by the sender - see ipcAttInShmMinBytes
+                att->attachment = hmbdcShmHandleToAddr(att->shmHandle);
+                att->clientData[0] = (uint64_t)&hmbdcShmDeallocator;
+                att->afterConsumedCleanupFunc = [](app::hasMemoryAttachment* h) {
+                    auto hmbdc0cpyShmRefCount 
+                        = reinterpret_cast<std::atomic<size_t>*>(h->attachment) - 1;
+                    if (h->attachment && 1 == hmbdc0cpyShmRefCount->fetch_sub(1)) {
+                        auto& hmbdcShmDeallocator
+                            = *(std::function<void (uint8_t*)>*)h->clientData[0];
+                        hmbdcShmDeallocator((uint8_t*)h->attachment);
+                    }
+                };
+                accSize = att->len;
+                return true;
             } else {
                 attAllocator(typeTagIn, att);
                 // att->attachment = malloc(att->len);
@@ -747,6 +787,7 @@ private:
         std::string schedPolicy_;
         int schedPriority_;
         uint32_t pumpMaxBlockingTimeUs_;
+        size_t ipcAttInShmMinBytes_;
         const uint16_t mod;
         const uint16_t res;
 
@@ -770,6 +811,7 @@ private:
         , schedPolicy_(cfg.getExt<std::string>("pumpSchedPolicy"))
         , schedPriority_(cfg.getExt<int>("pumpSchedPriority"))
         , pumpMaxBlockingTimeUs_(cfg.getHex<double>("pumpMaxBlockingTimeSec") * 1000000)
+        , ipcAttInShmMinBytes_(cfg.getExt<size_t>("ipcAttInShmMinBytes"))
         , mod(mod)
         , res(res) {
             pumpMaxBlockingTimeUs_ = std::min(1000000u, pumpMaxBlockingTimeUs_);
@@ -842,6 +884,25 @@ private:
         }
         
 
+        /**
+         * @brief send a big enough attachment through the shm attachment pool
+         * @return false if not sent that way - nothing is sent
+         */
+        template <typename ToSendType>
+        bool sendAttInShm(ToSendType& toSend, size_t readers, bool tryOnly) {
+            if constexpr (!IpcProperty::use_dev_mem 
+                && std::is_base_of<app::hasMemoryAttachment, ToSendType>::value) {
+                if (ipcAttInShmMinBytes_ 
+                    && toSend.app::hasMemoryAttachment::len >= ipcAttInShmMinBytes_
+                    && !toSend.template holdShmHandle<ToSendType>()) {
+                    return tryOnly 
+                        ? ipcTransport_.trySendAttInShm(toSend, readers)
+                        : ipcTransport_.sendAttInShm(toSend, readers);
+                }
+            }
+            return false;
+        }
+
         template <app::MessageC Message>
         void send(Message&& message) {
             using M = typename std::decay<Message>::type;
@@ -882,9 +943,15 @@ private:
                                     -> fetch_add(intDiff, std::memory_order_release);
                             }
                         }
-                        ipcTransport_.send(std::move(toSend));
+                        if (!sendAttInShm(toSend, intDiff, false)) {
+                            ipcTransport_.send(std::move(toSend));
+                        }
                     } else if constexpr(std::is_base_of<app::hasMemoryAttachment, M>::value) {
                         auto toSend = ToSendType{hmbdcAvoidIpcFrom, message};
+                        if (!disableNet) {
+                            //keep the att around
+                            toSend.afterConsumedCleanupFunc = nullptr;
+                        }
                         if constexpr (app::has_hmbdcIsAttInShm<ToSendType>::value) {
                             if (toSend.template holdShmHandle<ToSendType>()) {
                                 toSend.hmbdcIsAttInShm = true;
@@ -894,7 +961,9 @@ private:
                                     -> fetch_add(intDiff, std::memory_order_release);
                             }
                         }
-                        ipcTransport_.send(std::move(toSend));
+                        if (!sendAttInShm(toSend, intDiff, false)) {
+                            ipcTransport_.send(std::move(toSend));
+                        }
                     } else {
                         ipcTransport_.template sendInPlace<ToSendType>(hmbdcAvoidIpcFrom, message);
                     }
@@ -965,7 +1034,8 @@ private:
                                     -> fetch_add(intDiff, std::memory_order_release);
                             }
                         }
-                        res = ipcTransport_.trySend(toSend);
+                        res = sendAttInShm(toSend, intDiff, true) 
+                            || ipcTransport_.trySend(toSend);
                         if (!res) {
                             if constexpr (app::has_hmbdcIsAttInShm<ToSendType>::value) {
                                 if (toSend.template holdShmHandle<ToSendType>()) {
@@ -979,6 +1049,10 @@ private:
                         }
                     } else if constexpr(std::is_base_of<app::hasMemoryAttachment, M>::value) {
                         auto toSend = ToSendType{hmbdcAvoidIpcFrom, message};
+                        if (!disableNet) {
+                            //keep the att around
+                            toSend.afterConsumedCleanupFunc = nullptr;
+                        }
                         if constexpr (app::has_hmbdcIsAttInShm<ToSendType>::value) {
                             if (toSend.template holdShmHandle<ToSendType>()) {
                                 toSend.hmbdcIsAttInShm = true;
@@ -988,7 +1062,8 @@ private:
                                     -> fetch_add(intDiff, std::memory_order_release);
                             }
                         }
-                        res = ipcTransport_.trySend(toSend);
+                        res = sendAttInShm(toSend, intDiff, true) 
+                            || ipcTransport_.trySend(toSend);
                         if (!res) {
                             if constexpr (app::has_hmbdcIsAttInShm<ToSendType>::value) {
                                 if (toSend.template holdShmHandle<ToSendType>()) {
@@ -1043,8 +1118,18 @@ private:
                 }
 
                 using ToAvoidClangCrash = domain_detail::ipc_from<app::JustBytes>;
-                ipcTransport_.template sendJustBytesInPlace<ToAvoidClangCrash>(
-                    tag, bytes, len, att, hmbdcAvoidIpcFrom);
+                auto attInShm = false;
+                if constexpr (!IpcProperty::use_dev_mem) {
+                    attInShm = att && ipcAttInShmMinBytes_ && att->len >= ipcAttInShmMinBytes_
+                        && ipcTransport_.template sendJustBytesAttInShmInPlace<ToAvoidClangCrash>(
+                            tag, bytes, len, att
+                            , pOutboundSubscriptions_->check(tag) - inboundSubscriptions_.check(tag)
+                            , hmbdcAvoidIpcFrom);
+                }
+                if (!attInShm) {
+                    ipcTransport_.template sendJustBytesInPlace<ToAvoidClangCrash>(
+                        tag, bytes, len, att, hmbdcAvoidIpcFrom);
+                }
             }
 
             if constexpr (has_net_send_eng) {
@@ -1062,7 +1147,8 @@ private:
             for (;hmbdc_likely(!this->batchDone_ && it != end); ++it) {    
                 auto& h = *static_cast<app::MessageHead*>(*it);
                 auto tagInEffect = h.typeTag;
-                if (tagInEffect == app::InBandHasMemoryAttachment<app::Flush>::typeTag) {
+                if (tagInEffect == app::InBandHasMemoryAttachment<app::Flush>::typeTag
+                    || tagInEffect == app::InBandShmAttachment::typeTag) {
                     tagInEffect = h.scratchpad().ipc.hd.inbandUnderlyingTypeTag;
                 }
                 if (hmbdc_unlikely(tagInEffect > app::LastSystemMessage::typeTag
@@ -1252,6 +1338,15 @@ public:
                     , ownership);
             }
             pOutboundSubscriptions_ = allocator_->template allocate<TypeTagSet>(SMP_CACHE_BYTES);
+            auto blackboardSlotCount = config_.getExt<size_t>("ipcBlackboardSlotCount");
+            if (blackboardSlotCount) {
+                blackboard_.emplace((NetProtocol::instance().getTipsDomainName(config_) + "-bb").c_str()
+                    , blackboardSlotCount
+                    , IpcTransport::MAX_MESSAGE_SIZE != 0
+                        ? IpcTransport::MAX_MESSAGE_SIZE
+                        : config_.getExt<size_t>("ipcMaxMessageSizeRuntime")
+                    , ownership);
+            }
 
             ipcTransport_->setSecondsBetweenPurge(
                 config_.getExt<uint32_t>("ipcPurgeIntervalSeconds"));
@@ -1651,6 +1746,49 @@ public:
         }
     }
 
+    /**
+     * @brief publish the latest value of a Message into the IPC blackboard
+     * @details the Message does not go through the IPC ring, local or network paths -
+     * it overwrites the blackboard slot of its (tag, hmbdc_conflate_key) which any
+     * process in the IPC domain could read using readLatest() without consuming the IPC ring.
+     * Requires ipcBlackboardSlotCount config to be non 0
+     * 
+     * @tparam Message trivially copyable Message
+     * @param m message
+     */
+    template <app::MessageC Message>
+    void publishLatest(Message const& m) {
+        if (hmbdc_unlikely(!blackboard_)) {
+            HMBDC_THROW(std::logic_error, "IPC blackboard not configured - see ipcBlackboardSlotCount");
+        }
+        blackboard_->write(m);
+    }
+
+    /**
+     * @brief read the latest value of a Message from the IPC blackboard
+     * 
+     * @tparam Message trivially copyable Message
+     * @param m output
+     * @param key the hmbdc_conflate_key of the Message, 0 if the Message does not have the member
+     * @return the version of the value, increases by 1 per publishLatest(); 0 if never published
+     */
+    template <app::MessageC Message>
+    uint64_t readLatest(Message& m, uint64_t key = 0) const {
+        if (hmbdc_unlikely(!blackboard_)) {
+            HMBDC_THROW(std::logic_error, "IPC blackboard not configured - see ipcBlackboardSlotCount");
+        }
+        return blackboard_->read(m, key);
+    }
+
+    /**
+     * @brief the IPC blackboard if configured
+     * @details see Blackboard - it could be polled by version() before reading
+     * @return Blackboard* nullptr if not configured
+     */
+    Blackboard* blackboard() {
+        return blackboard_ ? &*blackboard_ : nullptr;
+    }
+
     /**
      * @brief allocate in shm to be hold in a hasSharedPtrAttachment to be published later
      * The release of it is auto handled in TIPS after being published
@@ -3,9 +3,80 @@
 #include "hmbdc/tips/Node.hpp"
 #include "hmbdc/MetaUtils.hpp"
 #include <utility>
+#include <array>
+#include <memory>
+#include <algorithm>
 
 namespace hmbdc::tips {
 
+namespace tick_node_detail {
+HMBDC_CLASS_HAS_DECLARE(hmbdc_tick_ts);
+
+template <typename Message>
+time::SysTime timestampOf(Message const& msg) {
+    if constexpr (has_hmbdc_tick_ts<Message>::value) {
+        return msg.hmbdc_tick_ts;
+    } else {
+        return time::SysTime::now();
+    }
+}
+
+inline
+time::Duration distance(time::SysTime a, time::SysTime b) {
+    return a > b ? a - b : b - a;
+}
+
+/**
+ * @brief fixed capacity per input ring queues used by the approximate time synchronizer
+ */
+template <typename TickMessageCombo>
+struct SyncQueues;
+
+template <typename ...Messages>
+struct SyncQueues<std::tuple<Messages...>> {
+    enum {
+        MAX_DEPTH = 16,
+        INPUT_COUNT = sizeof...(Messages),
+    };
+    std::tuple<std::array<Messages, MAX_DEPTH>...> msgs;
+    time::SysTime ts[INPUT_COUNT][MAX_DEPTH];
+    size_t head[INPUT_COUNT] = {0};
+    size_t size[INPUT_COUNT] = {0};
+    size_t const depth;
+
+    explicit SyncQueues(size_t depth)
+    : depth(std::max<size_t>(1, std::min<size_t>(depth, MAX_DEPTH))) {}
+
+    template <size_t i, typename Message>
+    void push(Message const& msg, time::SysTime t) {
+        if (size[i] == depth) pop(i, 1);
+        auto pos = (head[i] + size[i]++) % MAX_DEPTH;
+        std::get<i>(msgs)[pos] = msg;
+        ts[i][pos] = t;
+    }
+
+    time::SysTime tsAt(size_t i, size_t k) const {
+        return ts[i][(head[i] + k) % MAX_DEPTH];
+    }
+
+    void pop(size_t i, size_t n) {
+        head[i] = (head[i] + n) % MAX_DEPTH;
+        size[i] -= n;
+    }
+
+    bool allHaveOne() const {
+        return std::all_of(size, size + INPUT_COUNT, [](auto s) {return s != 0;});
+    }
+
+    template <size_t ...is>
+    void extract(std::tuple<Messages...>& combo, size_t const* picked
+        , std::index_sequence<is...>) {
+        ((std::get<is>(combo) = std::move(std::get<is>(msgs)[(head[is] + picked[is]) % MAX_DEPTH])), ...);
+        ((pop(is, picked[is] + 1)), ...);
+    }
+};
+} //tick_node_detail
+
 /**
  * @brief Tick is a frequently used concept in robotics, in which a Node groups a set of input messages, and when 
  * all messages in the group are received (with some condition checked - for example all messages have the close enough timestamps), 
@@ -23,7 +94,12 @@ namespace hmbdc::tips {
  * void nontickCb(MessageC const& m){...}
  * @tparam SendMessageTupleIn The std tuple list all the publish Message types.
  * Cannot not compile if trying to publish a message not listed here.
- * @
+ * 
+ * In addition to the above "latest message of each input" tick conditions, an approximate
+ * time synchronizer mode is available (see the ApproxTimeSync ctor): each input keeps a small
+ * fixed capacity queue so a slightly early message is not overwritten, and the set of messages
+ * best aligned by timestamps within a slop fires the tick. A message's timestamp is its
+ * hmbdc_tick_ts data member (time::SysTime) if the type has one, or its arrival time otherwise.
  */
 template <typename CcNode
     , app::MessageTupleC TickMessageComboIn
@@ -39,9 +115,20 @@ class TickNode : public Node<CcNode
     TickMessageComboIn tickMsgCombo_;
     time::SysTime comboTimestamps_[std::tuple_size_v<TickMessageComboIn>];
     std::function<bool (TickMessageComboIn const&, time::SysTime*, size_t)> tickPred_;
+    using SyncQueues = tick_node_detail::SyncQueues<TickMessageComboIn>;
+    std::unique_ptr<SyncQueues> syncQueues_;
+    time::Duration syncSlop_;
 public:
     using TickMessageCombo = TickMessageComboIn;
 
+    /**
+     * @brief the approximate time synchronizer mode settings
+     */
+    struct ApproxTimeSync {
+        time::Duration slop;    /// max timestamp spread of a set of messages to tick
+        size_t queueDepth = SyncQueues::MAX_DEPTH; /// max messages queued per input, up to 16
+    };
+
     /**
      * @brief Construct a new Tick Node object by specifying the tick condition to be
      * the group of messages need to be received within a specific duration (normally a short duration)
@@ -66,6 +153,20 @@ public:
     explicit TickNode(std::function<bool (TickMessageCombo&, time::SysTime*, size_t)> tickPred)
     : tickPred_(tickPred) {}
 
+    /**
+     * @brief Construct a new Tick Node object in the approximate time synchronizer mode
+     * @details the per input queues are allocated here once, no allocation afterwards.
+     * Whenever all inputs have queued messages, the message closest in time to the latest
+     * of the queue heads is picked from each input; if they are within the slop, the tick
+     * fires with them and they (and the older ones) are dequeued, otherwise the message
+     * that can no longer be matched is dropped and the matching is retried
+     * 
+     * @param sync the settings
+     */
+    explicit TickNode(ApproxTimeSync sync)
+    : syncQueues_(std::make_unique<SyncQueues>(sync.queueDepth))
+    , syncSlop_(sync.slop) {}
+
     /**
      * @brief implementation detail - do not change
      */
@@ -74,6 +175,9 @@ public:
         auto constexpr index = index_in_tuple<Message, TickMessageCombo>::value;
         if constexpr(index >= std::tuple_size_v<TickMessageComboIn>) {
             static_cast<CcNode*>(this)->nontickCb(msg);
+        } else if (syncQueues_) {
+            syncQueues_->template push<index>(msg, tick_node_detail::timestampOf(msg));
+            syncTick();
         } else {
             comboTimestamps_[index] = time::SysTime::now();
             std::get<index>(tickMsgCombo_) = msg;
@@ -85,5 +189,44 @@ public:
             }
         }
     }
+
+private:
+    void syncTick() {
+        auto& q = *syncQueues_;
+        auto constexpr n = (size_t)SyncQueues::INPUT_COUNT;
+        while (q.allHaveOne()) {
+            size_t pivotQ = 0;
+            for (size_t i = 1; i < n; ++i) {
+                if (q.tsAt(i, 0) > q.tsAt(pivotQ, 0)) pivotQ = i;
+            }
+            auto pivot = q.tsAt(pivotQ, 0);
+            size_t picked[n];
+            auto lo = pivot, hi = pivot;
+            for (size_t i = 0; i < n; ++i) {
+                picked[i] = 0;
+                for (size_t k = 1; k < q.size[i]; ++k) {
+                    if (tick_node_detail::distance(q.tsAt(i, k), pivot)
+                        < tick_node_detail::distance(q.tsAt(i, picked[i]), pivot)) {
+                        picked[i] = k;
+                    }
+                }
+                lo = std::min(lo, q.tsAt(i, picked[i]));
+                hi = std::max(hi, q.tsAt(i, picked[i]));
+            }
+            if (hi - lo <= syncSlop_) {
+                TickMessageCombo combo;
+                q.extract(combo, picked, std::make_index_sequence<n>{});
+                call_member_in_arg_pack(static_cast<CcNode*>(this), &CcNode::tickCb, std::move(combo));
+            } else if (hi > pivot + syncSlop_) {
+                q.pop(pivotQ, 1); /// nothing close enough to the pivot in some input
+            } else {
+                size_t oldestQ = 0;
+                for (size_t i = 1; i < n; ++i) {
+                    if (q.tsAt(i, 0) < q.tsAt(oldestQ, 0)) oldestQ = i;
+                }
+                q.pop(oldestQ, 1);
+            }
+        }
+    }
 };
 } // hmbdc::tips
@@ -264,4 +264,111 @@ struct TypeTagSetST {
     private:
     std::unordered_map<TagType, uint8_t> subCounts_;
 };
+
+/**
+ * @brief inverted index from a type tag to the bitmap of the subscribers (sessions)
+ * subscribing to it
+ * @details each subscriber owns a slot (bit) - shared by all the sessions of a send engine
+ * instead of each session keeping its own TypeTagSet. A tag's bitmap is allocated
+ * when the tag is first subscribed and is kept till the index goes.
+ * Different subscribers can change their own subscriptions from different threads.
+ */
+struct TypeTagSubscriberIndex {
+    using TagType = uint16_t;
+    enum {
+        capacity = 1u << (sizeof(TagType) * 8),
+        maxSubscribers = 1024,
+        wordCount = maxSubscribers / 64,
+    };
+
+    TypeTagSubscriberIndex() = default;
+    TypeTagSubscriberIndex(TypeTagSubscriberIndex const&) = delete;
+    TypeTagSubscriberIndex& operator = (TypeTagSubscriberIndex const&) = delete;
+    ~TypeTagSubscriberIndex() {
+        for (auto& b : bitmaps_) {
+            delete [] b.load(std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief take a free slot for a new subscriber
+     * @return the slot, throws when there are already maxSubscribers
+     */
+    size_t addSubscriber() {
+        for (auto i = 0u; i < wordCount; ++i) {
+            auto used = used_[i].load(std::memory_order_relaxed);
+            while (~used) {
+                auto bit = __builtin_ctzll(~used);
+                if (used_[i].compare_exchange_weak(used, used | (1ul << bit))) {
+                    return i * 64 + bit;
+                }
+            }
+        }
+        HMBDC_THROW(std::out_of_range, "too many subscribers, max=" << maxSubscribers);
+    }
+
+    /**
+     * @brief give the slot back after clearing all its subscriptions
+     */
+    void removeSubscriber(size_t slot) {
+        auto mask = ~(1ul << (slot % 64));
+        for (auto& b : bitmaps_) {
+            auto p = b.load(std::memory_order_acquire);
+            if (p) p[slot / 64].fetch_and(mask, std::memory_order_relaxed);
+        }
+        used_[slot / 64].fetch_and(mask, std::memory_order_release);
+    }
+
+    /**
+     * @return true if the subscriber was not subscribing to the tag before
+     */
+    bool set(TagType tag, size_t slot) {
+        auto bit = 1ul << (slot % 64);
+        return !(bitmap(tag)[slot / 64].fetch_or(bit, std::memory_order_relaxed) & bit);
+    }
+
+    /**
+     * @return true if the subscriber was subscribing to the tag before
+     */
+    bool unset(TagType tag, size_t slot) {
+        auto p = bitmaps_[tag].load(std::memory_order_acquire);
+        if (!p) return false;
+        auto bit = 1ul << (slot % 64);
+        return p[slot / 64].fetch_and(~bit, std::memory_order_relaxed) & bit;
+    }
+
+    bool check(TagType tag, size_t slot) const {
+        auto p = bitmaps_[tag].load(std::memory_order_acquire);
+        return p && (p[slot / 64].load(std::memory_order_relaxed) & (1ul << (slot % 64)));
+    }
+
+    /**
+     * @brief call r(tag) for each tag the subscriber subscribes to
+     */
+    template <typename TagRecver>
+    void exportTo(size_t slot, TagRecver&& r) const {
+        for (uint32_t i = 0; i < capacity; i++) {
+            if (check((TagType)i, slot)) {
+                r((TagType)i);
+            }
+        }
+    }
+
+    private:
+    std::atomic<uint64_t>* bitmap(TagType tag) {
+        auto p = bitmaps_[tag].load(std::memory_order_acquire);
+        if (hmbdc_unlikely(!p)) {
+            auto newP = new std::atomic<uint64_t>[wordCount]{};
+            if (bitmaps_[tag].compare_exchange_strong(p, newP, std::memory_order_acq_rel)) {
+                p = newP;
+            } else { //another subscriber got there first
+                delete [] newP;
+            }
+        }
+        return p;
+    }
+
+    std::atomic<std::atomic<uint64_t>*> bitmaps_[capacity] = {};
+    std::atomic<uint64_t> used_[wordCount] = {};
+};
 }}
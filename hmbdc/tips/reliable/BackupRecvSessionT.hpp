@@ -16,6 +16,8 @@
 #include <memory>
 #include <utility>
 #include <regex>
+#include <random>
+#include <vector>
 #include <assert.h>
 #include <iostream>
 
@@ -62,7 +64,18 @@ struct BackupRecvSessionT
     , stopped_(false)
     , recvBackupMessageCount_(0)
     , gapPending_(false)
-    , gapPendingSeq_(0) {
+    , gapPendingSeq_(0)
+    , nakRepair_(config.getExt<bool>("nakRepair"))
+    , nakBackoff_(time::Duration::microseconds(config.getExt<uint32_t>("nakBackoffMicrosec")))
+    , nakRetry_(time::Duration::microseconds(config.getExt<uint32_t>("nakRetryMicrosec")))
+    , nakMaxRetries_(config.getExt<uint32_t>("nakMaxRetries"))
+    , nakRand_(getpid() ^ (uint32_t)(uintptr_t)this)
+    , fecWindowBytes_(config.getExt<size_t>("fecRecvWindowBytes"))
+    , fecWait_(time::Duration::microseconds(config.getExt<uint32_t>("fecWaitMicrosec"))) {
+        size_t cap = 1;
+        while (cap < config.getExt<size_t>("nakMaxGap")) cap <<= 1;
+        stashMask_ = cap - 1;
+        stashSlotSize_ = config.getExt<size_t>("mtu");
         setCallback(
             [this](hmbdc::time::TimerManager& tm, hmbdc::time::SysTime const& now) {
                 sendGapReport(seqArb_.expectingSeq(), 0);
@@ -74,7 +87,8 @@ struct BackupRecvSessionT
     BackupRecvSessionT& operator = (BackupRecvSessionT const&) = delete;
     virtual ~BackupRecvSessionT() {
         ::free(buf_);
-        HMBDC_LOG_N("BackupRecvSession retired: ", id(), " lifetime recved:", recvBackupMessageCount_);
+        HMBDC_LOG_N("BackupRecvSession retired: ", id(), " lifetime recved:", recvBackupMessageCount_
+            , " fec recovered datagrams:", fecRecovered_);
     }
 
     void stop() {
@@ -142,21 +156,243 @@ struct BackupRecvSessionT
         // if (seq != std::numeric_limits<HMBDC_SEQ_TYPE>::max()) 
         //     HMBDC_LOG_N(h->typeTag(), '@', seq);
         auto a = arb(0, seq, h);
+        if (hmbdc_unlikely(fecActive_) && a && seq != std::numeric_limits<HMBDC_SEQ_TYPE>::max()) {
+            fecRecord(seq, h);
+        }
         if (a == 1) {
-            auto tag = h->typeTag();
-            if (tag == app::StartMemorySegTrain::typeTag) {
-                tag = h->template wrapped<app::StartMemorySegTrain>().inbandUnderlyingTypeTag;
-            }
-            if (subscriptions_.check(tag)) {
-                outputBuffer_.put(h);
+            deliver(h);
+            if (hmbdc_unlikely(stashCount_)) {
+                drainStash();
             }
         }
         return a;
     }
+
+    /**
+     * @brief check if a Nak needs to go out now - 
+     * or the tcp backup is asked when the gap is not repaired in time
+     * 
+     * @param seq output - first missing seq
+     * @param len output - missing range length
+     * @return true if the caller needs to multicast a Nak for (seq, len)
+     */
+    bool nakDue(HMBDC_SEQ_TYPE& seq, size_t& len) {
+        if (hmbdc_likely(!nakPending_)) return false;
+        auto expect = seqArb_.expectingSeq();
+        if (expect >= nakSeq_ + nakLen_ || gapPending_) {
+            nakPending_ = false;
+            return false;
+        }
+        auto now = time::SysTime::now();
+        if (now < nakDue_) return false;
+        if (nakTries_ == (nakRepair_ ? nakMaxRetries_ : 0u)) {
+            //multicast repair did not work out, go the tcp way for everything missing
+            auto end = std::max(nakSeq_ + nakLen_, stashEnd_);
+            clearStash();
+            nakPending_ = false;
+            sendGapReport(expect, end - expect);
+            return false;
+        }
+        nakTries_++;
+        nakDue_ = now + nakRetry_;
+        seq = expect;
+        len = nakSeq_ + nakLen_ - expect;
+        return true;
+    }
+
+    /**
+     * @brief nakRepair mode - another receiver asked for the range already, hold back
+     */
+    void nakOverheard(HMBDC_SEQ_TYPE seq, size_t len, time::SysTime now) {
+        if (nakPending_ && seq <= nakSeq_ && seq + len > nakSeq_) {
+            nakTries_++;
+            nakDue_ = now + nakRetry_;
+        }
+    }
     
+    /**
+     * @brief a FecParity from the sender - rebuild the one datagram of its stripe 
+     * that went missing if all the others are still at hand
+     * @details message copies are kept only after the first FecParity is seen
+     */
+    template <typename FecParity>
+    void fecParity(FecParity const& parity) {
+        if (hmbdc_unlikely(!fecActive_)) {
+            if (!fecWindowBytes_) return;
+            size_t cap = 1;
+            while (cap < fecWindowBytes_ / 64) cap <<= 1;
+            fecEntries_.resize(cap, FecEntry{std::numeric_limits<HMBDC_SEQ_TYPE>::max(), 0, 0});
+            fecEntryMask_ = cap - 1;
+            fecBytes_.resize(fecWindowBytes_);
+            fecActive_ = true;
+            return;
+        }
+        auto table = parity.table();
+        size_t count = parity.datagramCount;
+        size_t missing = count;
+        for (size_t i = 0; i < count; ++i) {
+            if (!fecFind(table[i].firstSeq)) {
+                if (missing != count) return; //more than one lost
+                missing = i;
+            }
+        }
+        if (missing == count) return;
+        auto const& lost = table[missing];
+        auto expect = seqArb_.expectingSeq();
+        if (expect == std::numeric_limits<HMBDC_SEQ_TYPE>::max()
+            || lost.firstSeq + lost.msgCount <= expect) return; //nothing to recover
+        size_t parityLen = parity.parityLen;
+        fecBuf_.assign(parity.parity(), parity.parity() + parityLen);
+        for (size_t i = 0; i < count; ++i) {
+            if (i == missing) continue;
+            size_t off = 0;
+            for (HMBDC_SEQ_TYPE seq = table[i].firstSeq; seq < table[i].firstSeq + table[i].msgCount; ++seq) {
+                auto e = fecFind(seq);
+                if (!e || off + e->len > parityLen) return; //got it from tcp or too old
+                auto p = &fecBytes_[e->pos % fecBytes_.size()];
+                for (size_t j = 0; j < e->len; ++j) {
+                    fecBuf_[off + j] ^= p[j];
+                }
+                off += e->len;
+            }
+        }
+        fecRecovered_++;
+        auto p = fecBuf_.data();
+        size_t bytes = lost.len;
+        while (bytes >= sizeof(TransportMessageHeader)) {
+            auto h = reinterpret_cast<TransportMessageHeader*>(p);
+            auto wireSize = h->wireSize();
+            if (wireSize > bytes) break;
+            accept(h); //0 means the tcp backup is on it already
+            p += wireSize;
+            bytes -= wireSize;
+        }
+    }
+
     SendFrom const sendFrom;
 private:
     using OutputBuffer = AttBufferAdaptor<OutputBufferIn, TransportMessageHeader, AttachmentAllocator>;
+    void deliver(TransportMessageHeader* h) {
+        auto tag = h->typeTag();
+        if (tag == app::StartMemorySegTrain::typeTag) {
+            tag = h->template wrapped<app::StartMemorySegTrain>().inbandUnderlyingTypeTag;
+        }
+        if (subscriptions_.check(tag)) {
+            outputBuffer_.put(h);
+        }
+    }
+
+    /**
+     * @brief FEC - keep a copy of a multicast message in the window for rebuilding
+     */
+    void fecRecord(HMBDC_SEQ_TYPE seq, TransportMessageHeader const* h) {
+        auto len = h->wireSize();
+        auto cap = fecBytes_.size();
+        if (len > cap || fecFind(seq)) return;
+        auto off = fecPos_ % cap;
+        if (off + len > cap) { //no wrapping around within a message
+            fecPos_ += cap - off;
+            off = 0;
+        }
+        memcpy(&fecBytes_[off], h, len);
+        fecEntries_[seq & fecEntryMask_] = FecEntry{seq, fecPos_, len};
+        fecPos_ += len;
+    }
+
+    struct FecEntry {
+        HMBDC_SEQ_TYPE seq;
+        size_t pos;
+        size_t len;
+    };
+
+    FecEntry const* fecFind(HMBDC_SEQ_TYPE seq) const {
+        auto const& e = fecEntries_[seq & fecEntryMask_];
+        if (e.seq != seq || fecPos_ - e.pos > fecBytes_.size()) return nullptr;
+        return &e;
+    }
+
+    /**
+     * @brief keep a message arriving after a gap until the gap is repaired 
+     * by Nak or FEC
+     * @return -1 if kept, 0 if the gap is too big and the tcp backup is asked instead
+     */
+    int stash(HMBDC_SEQ_TYPE seq, TransportMessageHeader* h) {
+        auto expect = seqArb_.expectingSeq();
+        if (hmbdc_unlikely(seq - expect > stashMask_ || h->wireSize() > stashSlotSize_)) {
+            //far behind - tcp backup is the last resort
+            auto end = std::max({seq, nakSeq_ + nakLen_, stashEnd_});
+            clearStash();
+            nakPending_ = false;
+            sendGapReport(expect, end - expect);
+            return 0;
+        }
+        if (stash_.empty()) {
+            stash_.resize((stashMask_ + 1) * stashSlotSize_);
+            stashSeqs_.resize(stashMask_ + 1, std::numeric_limits<HMBDC_SEQ_TYPE>::max());
+        }
+        auto i = seq & stashMask_;
+        if (stashSeqs_[i] != seq) {
+            memcpy(&stash_[i * stashSlotSize_], h, h->wireSize());
+            stashSeqs_[i] = seq;
+            stashCount_++;
+            stashEnd_ = std::max(stashEnd_, seq + 1);
+        }
+        scheduleNak(expect, seq);
+        return -1;
+    }
+
+    void drainStash() {
+        while (stashCount_) {
+            auto expect = seqArb_.expectingSeq();
+            auto i = expect & stashMask_;
+            if (stashSeqs_[i] != expect) break;
+            stashSeqs_[i] = std::numeric_limits<HMBDC_SEQ_TYPE>::max();
+            stashCount_--;
+            auto h = reinterpret_cast<TransportMessageHeader*>(&stash_[i * stashSlotSize_]);
+            seqArb_(0, expect, [](size_t) {});
+            deliver(h);
+        }
+        if (stashCount_) {
+            //next gap
+            auto expect = seqArb_.expectingSeq();
+            for (auto firstKept = expect + 1; firstKept <= expect + stashMask_; ++firstKept) {
+                if (stashSeqs_[firstKept & stashMask_] == firstKept) {
+                    scheduleNak(expect, firstKept);
+                    return;
+                }
+            }
+            clearStash(); //only stale ones left
+        }
+    }
+
+    void clearStash() {
+        if (stashCount_) {
+            std::fill(stashSeqs_.begin(), stashSeqs_.end(), std::numeric_limits<HMBDC_SEQ_TYPE>::max());
+            stashCount_ = 0;
+        }
+        stashEnd_ = 0;
+    }
+
+    /**
+     * @brief missing [from, to) - the Nak goes out after a random backoff so
+     * receivers seeing the same loss do not all Nak at the same time; 
+     * with FEC the FecParity is given fecWait_ to arrive first
+     */
+    void scheduleNak(HMBDC_SEQ_TYPE from, HMBDC_SEQ_TYPE to) {
+        if (nakPending_ && nakSeq_ == from) {
+            if (to > nakSeq_ + nakLen_) nakLen_ = to - nakSeq_;
+            return;
+        }
+        nakPending_ = true;
+        nakSeq_ = from;
+        nakLen_ = to - from;
+        nakTries_ = 0;
+        auto backoff = nakRepair_ ? nakBackoff_.microseconds() : 0;
+        nakDue_ = time::SysTime::now() 
+            + time::Duration::microseconds(backoff ? nakRand_() % backoff : 0);
+        if (fecActive_) nakDue_ += fecWait_;
+    }
+
     void initializeConn() {
         int flags = fcntl(writeFd_.fd, F_GETFL, 0);
         flags &= ~O_NONBLOCK;
@@ -281,6 +517,13 @@ private:
         //UDP packet out of order case
         if (hmbdc_unlikely(gapPending_ && part == 0)) return 0; 
         if (seq != std::numeric_limits<HMBDC_SEQ_TYPE>::max()) {
+            if ((nakRepair_ || fecActive_) && part == 0) {
+                auto expect = seqArb_.expectingSeq();
+                if (hmbdc_unlikely(seq > expect 
+                    && expect != std::numeric_limits<HMBDC_SEQ_TYPE>::max())) {
+                    return stash(seq, h);
+                }
+            }
             auto res = seqArb_(part, seq, [](size_t) {
                 //impossible to get here
             });
@@ -295,7 +538,11 @@ private:
             auto nextSeq = alert.expectSeq;
 
             if (seqArb_.expectingSeq() < nextSeq) {
-                sendGapReport(seqArb_.expectingSeq(), nextSeq - seqArb_.expectingSeq());
+                if ((nakRepair_ || fecActive_) && nextSeq - seqArb_.expectingSeq() <= stashMask_) {
+                    scheduleNak(seqArb_.expectingSeq(), nextSeq);
+                } else {
+                    sendGapReport(seqArb_.expectingSeq(), nextSeq - seqArb_.expectingSeq());
+                }
             }
             // HMBDC_LOG_D(std::this_thread::get_id(), "=-1");
             return -1;
@@ -325,6 +572,33 @@ private:
     HMBDC_SEQ_TYPE gapPendingSeq_;
     uint16_t attTypeTag_;
     void* attUserScratchpad_;
+
+    bool const nakRepair_;
+    time::Duration const nakBackoff_;
+    time::Duration const nakRetry_;
+    uint32_t const nakMaxRetries_;
+    std::minstd_rand nakRand_;
+    bool nakPending_ = false;
+    HMBDC_SEQ_TYPE nakSeq_ = 0;
+    size_t nakLen_ = 0;
+    uint32_t nakTries_ = 0;
+    time::SysTime nakDue_;
+    std::vector<char> stash_; /// messages after a gap, slot by seq, allocated on first gap
+    std::vector<HMBDC_SEQ_TYPE> stashSeqs_;
+    size_t stashMask_ = 0;
+    size_t stashSlotSize_ = 0;
+    size_t stashCount_ = 0;
+    HMBDC_SEQ_TYPE stashEnd_ = 0;
+
+    size_t const fecWindowBytes_;
+    time::Duration const fecWait_;
+    bool fecActive_ = false;
+    std::vector<char> fecBytes_; /// recent multicast messages as they were on the wire
+    size_t fecPos_ = 0;
+    std::vector<FecEntry> fecEntries_; /// where the recent messages are in fecBytes_, slot by seq
+    size_t fecEntryMask_ = 0;
+    std::vector<char> fecBuf_;
+    size_t fecRecovered_ = 0;
 };
 } //backuprecvsessiont_detail
 
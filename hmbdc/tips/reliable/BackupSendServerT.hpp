@@ -61,6 +61,10 @@ struct BackupSendServerT {
         return advertisingMessages_;
     }
 
+    sockaddr_in const& localAddr() const {
+        return serverFd_.localAddr;
+    }
+
 protected:
     app::Config config_;
     TcpEpollFd serverFd_;
@@ -98,6 +102,7 @@ struct AsyncBackupSendServerT
         for (auto it = sessions_.begin(); it != sessions_.end();) {
             if (hmbdc_unlikely(!(*it)->runOnce())) {
                 (*it)->stop();
+                retire(**it);
                 sessions_.erase(it++);
             } else {
                 if (newSeq_ > (*it)->bufItNext_.seq_) {
@@ -164,10 +169,34 @@ struct AsyncBackupSendServerT
         }
         HMBDC_LOG_C((*leastSessIt)->id(), " too slow, dropping");
         (*leastSessIt)->stop();
+        retire(**leastSessIt);
         sessions_.erase(leastSessIt);
     }
 
+    /**
+     * @brief how many gap reports (receivers missing messages) came in so far
+     */
+    size_t gapReportCount() const {
+        auto res = retiredGapReportCount_;
+        for (auto const& s : sessions_) res += s->gapReportCount_;
+        return res;
+    }
+
+    /**
+     * @brief how many periodic receive progress reports came in so far
+     */
+    size_t progressReportCount() const {
+        auto res = retiredProgressReportCount_;
+        for (auto const& s : sessions_) res += s->progressReportCount_;
+        return res;
+    }
+
 private:
+    void retire(BackupSendSession const& s) {
+        retiredGapReportCount_ += s.gapReportCount_;
+        retiredProgressReportCount_ += s.progressReportCount_;
+    }
+
     void doAccept() HMBDC_RESTRICT {
         auto& serverFd_ = this->serverFd_;
         auto& serverAddr_ = this->serverAddr_;
@@ -198,6 +227,7 @@ private:
                     , rater_
                     , it
                     , maxSendBatch_
+                    , subscriberIndex_
                     , outboundSubscriptions_);
                 s->start();
                 sessions_.insert(s);
@@ -208,6 +238,7 @@ private:
     }
 
     using Sessions = std::unordered_set<typename BackupSendSession::ptr>;
+    TypeTagSubscriberIndex subscriberIndex_; /// shared by sessions_, so declared ahead
     Sessions sessions_;
     Buffer& HMBDC_RESTRICT buffer_; 
     hmbdc::time::Rater& HMBDC_RESTRICT rater_;
@@ -216,6 +247,8 @@ private:
     ToCleanupAttQueue& toCleanupAttQueue_;
     size_t replayHistoryForNewRecv_;
     TypeTagSet& outboundSubscriptions_;
+    size_t retiredGapReportCount_ = 0;
+    size_t retiredProgressReportCount_ = 0;
 };
 
 } //backupsendservert_detail
@@ -44,9 +44,11 @@ struct BackupSendSessionT {
     , hmbdc::time::Rater& rater
     , Buffer::iterator bufIt
     , size_t maxSendBatchHint
+    , TypeTagSubscriberIndex& subscriberIndex
     , TypeTagSet& outboundSubscriptions)
     : buffer_(buffer)
     , rater_(rater)
+    , subscriberIndex_(subscriberIndex)
     , outboundSubscriptions_(outboundSubscriptions)
     , filledLen_(0)
     , initialized_(false)
@@ -81,14 +83,16 @@ struct BackupSendSessionT {
         char* addr = flush_;
         auto h = reinterpret_cast<TransportMessageHeader*>(addr);
         h->messagePayloadLen = 0;
+        slot_ = subscriberIndex_.addSubscriber();
     }
 
     BackupSendSessionT(BackupSendSessionT const&) = delete;
     BackupSendSessionT& operator = (BackupSendSessionT const&) = delete;
     virtual ~BackupSendSessionT() {
-        clientSubscriptions_.exportTo([this](uint16_t tag, auto&&) {
+        subscriberIndex_.exportTo(slot_, [this](uint16_t tag) {
             outboundSubscriptions_.sub(tag);
         });
+        subscriberIndex_.removeSubscriber(slot_);
 
         delete [] msghdrRelic_.msg_iov;
         HMBDC_LOG_N("BackupSendSessionT retired: ", id(), " lifetime sent:", sendBackupMessageCount_);
@@ -155,11 +159,11 @@ struct BackupSendSessionT {
                     void* ptr = *bufIt_++;
                     auto item = static_cast<TransportMessageHeader*>(ptr);
 
-                    bool ifResend = clientSubscriptions_.check(item->typeTag());
+                    bool ifResend = subscriberIndex_.check(item->typeTag(), slot_);
                     ifResend = ifResend && (item->typeTag() != app::MemorySeg::typeTag
-                        || clientSubscriptions_.check(item->template wrapped<app::MemorySeg>().inbandUnderlyingTypeTag));
+                        || subscriberIndex_.check(item->template wrapped<app::MemorySeg>().inbandUnderlyingTypeTag, slot_));
                     ifResend = ifResend && (item->typeTag() != app::StartMemorySegTrain::typeTag
-                        || clientSubscriptions_.check(item->template wrapped<app::StartMemorySegTrain>().inbandUnderlyingTypeTag));
+                        || subscriberIndex_.check(item->template wrapped<app::StartMemorySegTrain>().inbandUnderlyingTypeTag, slot_));
 
                         // HMBDC_LOG_N(item->wrapped<SeqMessage>().seq);
                     if (ifResend) {
@@ -239,13 +243,13 @@ private:
                 }
                 else if (data_[0] == '+') {
                     auto tag = (uint16_t)std::stoi(t);
-                    if (clientSubscriptions_.set(tag)) {
+                    if (subscriberIndex_.set(tag, slot_)) {
                         HMBDC_LOG_N(id_, " add outboundSubscriptions ", tag);
                         outboundSubscriptions_.add(tag);
                     }
                 } else if (data_[0] == '-') {
                     auto tag = (uint16_t)std::stoi(t);
-                    if (clientSubscriptions_.unset(tag)) {
+                    if (subscriberIndex_.unset(tag, slot_)) {
                         HMBDC_LOG_N(id_, " drop outboundSubscriptions ", tag);
                         outboundSubscriptions_.sub(tag);
                     }
@@ -254,6 +258,11 @@ private:
                     size_t len;
                     if (hmbdc_likely(2 == sscanf(data_ + 1, "%" SCNu64 ",%zu", &seq, &len))) {
                         toSendQueue_.push_back(std::make_tuple(seq, len));
+                        if (len) {
+                            gapReportCount_++;
+                        } else {
+                            progressReportCount_++;
+                        }
                     } else {
                         HMBDC_LOG_C(id(), ", received bad data ", data_ + 1, " stopping connection");
                         return false;
@@ -271,7 +280,8 @@ private:
 private:
     Buffer const& HMBDC_RESTRICT buffer_;
     hmbdc::time::Rater& HMBDC_RESTRICT rater_;
-    TypeTagSet clientSubscriptions_;
+    TypeTagSubscriberIndex& subscriberIndex_;
+    size_t slot_; /// this session's bit in subscriberIndex_
     TypeTagSet& outboundSubscriptions_;
     hmbdc::app::utils::EpollFd writeFd_;
     hmbdc::app::utils::EpollFd readFd_;
@@ -289,6 +299,8 @@ private:
     Buffer::iterator bufItNext_;
     char flush_[sizeof(TransportMessageHeader)];
     size_t sendBackupMessageCount_;
+    size_t gapReportCount_ = 0;
+    size_t progressReportCount_ = 0;
 };
 
 } //backupsendsessiont_detail
@@ -13,6 +13,7 @@ constexpr char const*  const DefaultUserConfig = R"|(
     "mtu"               : 1500,                         "__mtu"                         :"mtu, check ifconfig output for this value for each NIC in use",
     "multicastBoundToIface"     : true,                 "__multicastBoundToIface"       :"when doing multicast, the outgoing and incoming traffic is bound to a specific interface(ifaceAddr)",
     "nagling"           : false,                        "__nagling"                     :"should the backup tcp channel do nagling",
+    "nakRepair"         : false,                        "__nakRepair"                   :"receivers multicast a Nak for lost messages (after a random backoff, held back when another receiver Naks the same range) and the sender retransmits each range once on the multicast group - the tcp backup channel is only used when that does not work out or a receiver is far behind. the sender reads all the multicast group traffic to see the Naks",
     "schedPolicy"       : "SCHED_OTHER",                "__schedPolicy"                 :"engine thread schedule policy - check man page for allowed values",
     "schedPriority"     : 0,                            "__schedPriority"               :"engine thread schedule priority - check man page for allowed values",
     "tcpIfaceAddr"      : "ifaceAddr",                  "__tcpIfaceAddr"                :"ip address for the NIC interface for TCP (backup) traffic IO, default points to the same as ifaceAddr",
@@ -21,18 +22,28 @@ constexpr char const*  const DefaultUserConfig = R"|(
 
     "tx" :                               
     {
+        "congestionBackoffPercent"      : 70,           "__congestionBackoffPercent"    :"congestionControl mode - on loss the send rate is cut to this percent of itself",
+        "congestionControl"             : false,        "__congestionControl"           :"adapt the send rate to the receivers' feedback AIMD style: back off when gap reports or Naks come back, go up when progress reports come back without loss. sendBytesPerSec is the ceiling and rate control (sendBytesBurst) needs to be on. only the multicast is paced this way, the tcp backup channel keeps sendBytesPerSec",
+        "congestionIncreaseBytesPerSec" : 1000000,      "__congestionIncreaseBytesPerSec" :"congestionControl mode - how much the send rate goes up every recvReportDelayMicrosec without loss",
+        "congestionMinBytesPerSec"      : 1000000,      "__congestionMinBytesPerSec"    :"congestionControl mode - the send rate does not go below this",
+        "fecK"                          : 0,            "__fecK"                        :"forward error correction - after every fecK data udp packets send fecM XOR parity packets so a receiver rebuilds lost packets without asking, 0 turns it off. packets carry a little less data to leave room for the parity header",
+        "fecM"                          : 1,            "__fecM"                        :"forward error correction - parity packets per fecK data packets, each covers every fecM-th data packet so up to fecM consecutive lost packets are recoverable",
         "hmbdcName"                     : "rmcast-tx",  "__hmbdcName"                   :"engine thread name",
         "maxSendBatch"                  : 60,           "__maxSendBatch"                :"up to how many messages to send in a batch (within one udp packet)",
         "minRecvToStart"                : 0,            "__minRecvToStart"              :"start send when there are that many recipients (processes) online, otherwise hold the message in buffer - NOTE: buffer might get full and blocking",
+        "nakRepairBytesPerSec"          : 20000000,     "__nakRepairBytesPerSec"        :"nakRepair mode rate control for the multicast retransmits, 0 means no rate control",
+        "nakRepairHoldoffMicrosec"      : 1000,         "__nakRepairHoldoffMicrosec"    :"nakRepair mode - a range is not retransmitted again within this period no matter how many Naks ask for it",
         "netRoundtripLatencyMicrosec"   : 40,           "__netRoundtripLatencyMicrosec" :"the estmated round multicast network trip time",
         "outBufferSizePower2"           : 0,            "__outBufferSizePower2"         :"2^outBufferSizePower2 is the number of message that can be buffered in the engine, default 0 means automatically calculated based on 1MB as the low bound",
         "recvReportDelayMicrosec"       : 1000,         "__recvReportDelayMicrosec"     :"recv end needs to report the recved msg seq every so often",
         "replayHistoryForNewRecv"       : 0,            "__replayHistoryForNewRecv"     :"when a new recipient comes up, it will get the previous N (default 0) messages replayed (just) for it. if N >= out buffer size (see outBufferSizePower2), the out buffer will keep all messages and any new recipients will get every message ever sent, the out buffer needs to be big enough to hold all sent messages though",        
+        "sendBatchDatagrams"            : 16,           "__sendBatchDatagrams"          :"up to how many udp packets (each up to maxSendBatch messages) to send in one sendmmsg system call",
         "sendBytesBurst"                : 131071,       "__sendBytesBurst"              :"rate control for how many bytes can be sent in a burst, us the OS buffer size (131071) as reference, 0 means no rate control.",
         "sendBytesPerSec"               : 120000000,    "__sendBytesPerSec"             :"rate control for how many bytes per second - it is turned off by sendBytesBurst==0. user is STRONGLY recommneded to use rate control to garantee QoS if the throughput could be so high and saturate the network",
         "tcpSendBufferBytes"            : 0,            "__tcpSendBufferBytes"          :"OS buffer byte size for outgoing tcp, 0 means OS default value",
         "ttl"                           : 1,            "__ttl"                         :"the switch hop number",
         "typeTagAdvertisePeriodSeconds" : 1,            "__typeTagAdvertisePeriodSeconds" :"send engine advertise the message tags it covers every so often",
+        "udpGso"                        : false,        "__udpGso"                      :"use UDP_SEGMENT (GSO) so the kernel cuts one buffer into mtu sized packets - needs linux 4.18+, packets other than the last one in a batch are padded to mtu",
         "udpSendBufferBytes"            : 0,            "__udpSendBufferBytes"          :"OS buffer byte size for outgoing udp, 0 means OS default value",
         "waitForSlowReceivers"          : true,         "__waitForSlowReceivers"        :"when true, a slow receiver on the network subscribe to the message might slow down the sender and other recv engines since the sender needs to wait for it; when false, the slow receiver would be disconnected when it is detected to be slow. in that case the receiver will receive a disconnect message and it by default will reconnect some messages could be lost before the reconnection is done."
     },
@@ -40,9 +51,17 @@ constexpr char const*  const DefaultUserConfig = R"|(
     {
         "allowRecvWithinProcess"        : false,        "__allowRecvWithinProcess"      :"if receiving from the local process, this is an independent application level check from the OS level loopback",
         "cmdBufferSizePower2"           : 10,           "__cmdBufferSizePower2"         :"2^cmdBufferSizePower2 is the engine command buffer size - rarely need to change",
+        "fecRecvWindowBytes"            : 1048576,      "__fecRecvWindowBytes"          :"forward error correction - bytes of recent messages kept per sender to rebuild lost packets from the parity packets, 0 ignores the parity packets",
+        "fecWaitMicrosec"               : 1000,         "__fecWaitMicrosec"             :"forward error correction - how long to wait for the parity packets before a Nak or the tcp backup channel repairs a gap",
         "hmbdcName"                     : "rmcast-rx",  "__hmbdcName"                   :"thread name",
         "maxTcpReadBytes"               : 131072,       "__maxTcpReadBytes"             :"up to how many bytes to read in from the backup channel each time",
+        "nakBackoffMicrosec"            : 200,          "__nakBackoffMicrosec"          :"nakRepair mode - a receiver waits a random period up to this long before sending a Nak",
+        "nakMaxGap"                     : 1024,         "__nakMaxGap"                   :"nakRepair mode or forward error correction - a receiver missing more messages than this is far behind and goes to the tcp backup channel directly, it is also how many messages after a gap are kept waiting for the repair",
+        "nakMaxRetries"                 : 3,            "__nakMaxRetries"               :"nakRepair mode - how many Naks (own or overheard) before going to the tcp backup channel",
+        "nakRetryMicrosec"              : 2000,         "__nakRetryMicrosec"            :"nakRepair mode - how long to wait for the retransmit after a Nak is sent or overheard",
+        "recvBatchDatagrams"            : 16,           "__recvBatchDatagrams"          :"up to how many udp packets to read in one recvmmsg system call",
         "tcpRecvBufferBytes"            : 0,            "__tcpRecvBufferBytes"          :"OS buffer byte size for incoming tcp, 0 means OS default value",
+        "udpGro"                        : false,        "__udpGro"                      :"turn on UDP_GRO so the kernel can hand over several coalesced packets in one read - needs linux 5.0+, ignored if not supported",
         "udpRecvBufferBytes"            : 0,            "__udpRecvBufferBytes"          :"OS buffer byte size for incoming udp, 0 means OS default value"
     }
 }
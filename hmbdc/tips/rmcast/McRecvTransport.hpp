@@ -36,11 +36,16 @@ struct McRecvTransport
     , cmdBuffer_(cmdBuffer)
     , sendFrom_{0}
     , mcFd_(cfg)
-    , buf_(new char[mtu_])
+    , batch_(mcFd_.fd, config_.getExt<size_t>("recvBatchDatagrams"), mtu_
+        , config_.getExt<bool>("udpGro"))
+    , pktCount_(0)
+    , pktIndex_(0)
     , bufCur_(nullptr)
     , bytesRecved_(0)
     , subscriptions_(subscriptions)
-    , sessionDict_(sessionDict) {
+    , sessionDict_(sessionDict)
+    , mcAddr_(comm::inet::Endpoint(config_.getExt<std::string>("mcastAddr")
+        , config_.getExt<uint16_t>("mcastPort")).v) {
         uint32_t yes = 1;
         if (setsockopt(mcFd_.fd, SOL_SOCKET,SO_REUSEADDR, &yes, sizeof(yes)) < 0) {
             HMBDC_LOG_C("failed to set reuse address errno=", errno);
@@ -53,8 +58,7 @@ struct McRecvTransport
         }
 
         /* bind to receive address */
-        auto mcAddr = comm::inet::Endpoint(config_.getExt<std::string>("mcastAddr")
-            , config_.getExt<uint16_t>("mcastPort")).v;
+        auto mcAddr = mcAddr_;
         if (::bind(mcFd_.fd, (struct sockaddr *)&mcAddr, sizeof(mcAddr)) < 0) {
             HMBDC_THROW(std::runtime_error, "failed to bind " 
                 << config_.getExt<std::string>("mcastAddr") << ':'
@@ -89,6 +93,31 @@ struct McRecvTransport
         resumeRead();
     }
 
+/**
+ * @brief multicast a Nak to the group so the sender and the other receivers see it
+ * 
+ * @param ip sender's backup ip (network order)
+ * @param port sender's backup port
+ * @param seq first missing seq
+ * @param len missing range length
+ */
+    void sendNak(uint32_t ip, uint16_t port, HMBDC_SEQ_TYPE seq, size_t len) {
+        char buf[sizeof(TransportMessageHeader) + sizeof(app::MessageWrap<Nak>)];
+        auto h = new (buf) TransportMessageHeader;
+        auto& nak = (new (buf + sizeof(TransportMessageHeader)) app::MessageWrap<Nak>)
+            ->template get<Nak>();
+        nak.ip = ip;
+        nak.port = port;
+        nak.seq = seq;
+        nak.len = (uint32_t)len;
+        h->messagePayloadLen = sizeof(app::MessageWrap<Nak>);
+        h->setSeq(std::numeric_limits<HMBDC_SEQ_TYPE>::max());
+        if (sendto(mcFd_.fd, buf, sizeof(buf), MSG_NOSIGNAL|MSG_DONTWAIT
+            , (sockaddr*)&mcAddr_, sizeof(mcAddr_)) < 0) {
+            HMBDC_LOG_W("failed to send Nak errno=", errno);
+        }
+    }
+
 private:
     void resumeRead() {
         do {
@@ -96,25 +125,31 @@ private:
                 bytesRecved_ = 0;
             }
             if (hmbdc_likely(bytesRecved_)) {
-                if (!bufCur_) {
-                    bufCur_ = buf_;
-                }
                 while (bytesRecved_ >= sizeof(TransportMessageHeader)) {
                     auto h = reinterpret_cast<TransportMessageHeader*>(bufCur_);
                     auto wireSize = h->wireSize();
                     if (hmbdc_likely(bytesRecved_ >= wireSize)) {
-                        if (hmbdc_unlikely(h->typeTag() == TypeTagBackupSource::typeTag)) {
+                        if (hmbdc_unlikely(h->typeTag() == TypeTagBackupSource::typeTag
+                            || h->typeTag() == Nak::typeTag)) {
                             auto it = cmdBuffer_.claim();
                             auto b = static_cast<app::MessageHead*>(*it);
                             size_t l = h->messagePayloadLen;
                             l = std::min(cmdBuffer_.maxItemSize(), l);
                             memcpy(b, h->payload(), l);
-                            auto& bts = b->template get<TypeTagBackupSource>();
-                            bts.sendFrom = sendFrom_;
+                            if (b->typeTag == TypeTagBackupSource::typeTag) {
+                                auto& bts = b->template get<TypeTagBackupSource>();
+                                bts.sendFrom = sendFrom_;
+                            }
                             cmdBuffer_.commit(it);
                         } else {
                             auto session = sessionDict_.find(sendFrom_);
                             if (hmbdc_unlikely(session != sessionDict_.end())) {
+                                if (hmbdc_unlikely(h->typeTag() == FecParity::typeTag)) {
+                                    session->second->fecParity(h->template wrapped<FecParity>());
+                                    bytesRecved_ -= wireSize;
+                                    bufCur_ += wireSize;
+                                    continue;
+                                }
                                 auto a = session->second->accept(h);
                                 if (a == 0) {
                                     return; //wait for backup
@@ -130,32 +165,39 @@ private:
             }
             bufCur_ = nullptr;
             bytesRecved_ = 0;
-            auto addrLen = sizeof(sendFrom_);
-            if (mcFd_.isFdReady()) {
-                auto l = recvfrom(mcFd_.fd, buf_, mtu_, MSG_NOSIGNAL|MSG_DONTWAIT
-                , (sockaddr*)&sendFrom_, (socklen_t*)&addrLen);
-                if (hmbdc_unlikely(l < 0)) {
+            if (pktIndex_ < pktCount_) {
+                bufCur_ = batch_.packet(pktIndex_);
+                bytesRecved_ = batch_.len(pktIndex_);
+                sendFrom_ = batch_.from(pktIndex_);
+                pktIndex_++;
+            } else if (mcFd_.isFdReady()) {
+                auto n = batch_.recv(mcFd_.fd);
+                if (hmbdc_unlikely(n < 0)) {
                     if (!mcFd_.checkErr()) {
-                        HMBDC_LOG_C("recvmsg failed errno=", errno);
+                        HMBDC_LOG_C("recvmmsg failed errno=", errno);
                     }
                     return;
-                } else if (l == 0) {
+                } else if (n == 0) {
                     //nothing to do now
                     return;
                 }
-                bytesRecved_ = l;
+                pktCount_ = n;
+                pktIndex_ = 0;
             }
-        } while(bytesRecved_);
+        } while(bytesRecved_ || pktIndex_ < pktCount_);
     }
     
     hmbdc::pattern::MonoLockFreeBuffer& HMBDC_RESTRICT cmdBuffer_;
     sockaddr_in sendFrom_;
     udpcast::EpollFd mcFd_;
-    char* buf_;
+    udpcast::RecvBatch batch_;
+    size_t pktCount_;
+    size_t pktIndex_;
     char* bufCur_;
     size_t bytesRecved_;
     TypeTagSet const& HMBDC_RESTRICT subscriptions_;
     Ep2SessionDict& HMBDC_RESTRICT sessionDict_;
+    sockaddr_in mcAddr_;
 };
 } //mcrecvtransport_detail
 template <typename OutputBuffer, typename Ep2SessionDict>
@@ -12,10 +12,19 @@
 
 
 #include <boost/bind.hpp>
+#include <boost/circular_buffer.hpp>
 #include <memory>
+#include <tuple>
 
 #include <iostream>
 
+#include <netinet/udp.h>
+#include <sys/socket.h>
+
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+
 namespace hmbdc { namespace tips { namespace rmcast {
 
 namespace mcsendtransport_detail {
@@ -40,11 +49,21 @@ struct McSendTransport
     , toSend_{0}
     , rater_(rater)
     , maxSendBatch_(config_.getExt<size_t>("maxSendBatch"))
+    , sendBatchDatagrams_(std::max(config_.getExt<size_t>("sendBatchDatagrams"), size_t(1)))
+    , gso_(config_.getExt<bool>("udpGso"))
     , adPending_(false)
     , seqAlertPending_(false)
     , seqAlert_(nullptr)
     , startSending_(false)
-    , toCleanupAttQueue_(toCleanupAttQueue) {
+    , toCleanupAttQueue_(toCleanupAttQueue)
+    , repairRater_(hmbdc::time::Duration::seconds(1u)
+        , config_.getExt<size_t>("nakRepairBytesPerSec")
+        , std::max(config_.getExt<size_t>("sendBytesBurst"), mtu_)
+        , config_.getExt<size_t>("nakRepairBytesPerSec") != 0ul)
+    , repairHoldoff_(hmbdc::time::Duration::microseconds(
+        config_.getExt<uint32_t>("nakRepairHoldoffMicrosec")))
+    , fecK_(config_.getExt<size_t>("fecK"))
+    , fecM_(std::min(std::max(config_.getExt<size_t>("fecM"), size_t(1)), std::max(fecK_, size_t(1)))) {
         toSend_.msg_name = &mcAddr_;
         toSend_.msg_namelen = sizeof(mcAddr_);
         auto totalHead = sizeof(app::MessageHead) + sizeof(TransportMessageHeader);
@@ -59,7 +78,53 @@ struct McSendTransport
         h->setSeq(std::numeric_limits<HMBDC_SEQ_TYPE>::max());
         seqAlert_ = &(h->wrapped<SeqAlert>());
 
-        toSendMsgs_.reserve((maxSendBatch_ + 2) * 2); //double for MemorySeg cases
+        if (fecK_) {
+            /// a parity datagram carries the stripe's datagram table on top of the parity bytes
+            fecOverhead_ = sizeof(TransportMessageHeader) + sizeof(app::MessageWrap<FecParity>)
+                + (fecK_ + fecM_ - 1) / fecM_ * sizeof(FecParity::Datagram);
+            if (maxMessageSize_ + totalHead + fecOverhead_ > mtu_) {
+                HMBDC_THROW(std::out_of_range, "maxMessageSize need <= " 
+                    << mtu_ - totalHead - fecOverhead_ << " with fecK=" << fecK_ << " fecM=" << fecM_);
+            }
+        }
+        if (gso_ && maxMessageSize_ + totalHead + fecOverhead_ + PAD_HEAD_SIZE > mtu_) {
+            HMBDC_LOG_W("maxMessageSize too big to pad for UDP_SEGMENT, fall back to sendmmsg");
+            gso_ = false;
+        }
+        if (gso_) {
+            /// kernel segments one buffer into up to 64 datagrams of mtu_ bytes each
+            int segSize = (int)mtu_;
+            if (setsockopt(mcFd_.fd, SOL_UDP, UDP_SEGMENT, &segSize, sizeof(segSize)) < 0) {
+                HMBDC_LOG_W("UDP_SEGMENT not supported, fall back to sendmmsg, errno=", errno);
+                gso_ = false;
+            } else {
+                sendBatchDatagrams_ = std::min({sendBatchDatagrams_, size_t(64), size_t(65000 / mtu_)});
+                if (fecK_) { /// room for the parities of a group completing at the end of a batch
+                    auto room = fecM_ + 1;
+                    sendBatchDatagrams_ = sendBatchDatagrams_ > room ? sendBatchDatagrams_ - room : 1;
+                }
+                padZeros_.resize(mtu_);
+                padHeads_.resize(sendBatchDatagrams_ + (fecK_ ? fecM_ + 1 : 0));
+                for (auto& padHead : padHeads_) {
+                    auto addr = padHead.data();
+                    new (addr) TransportMessageHeader;
+                    new (addr + sizeof(TransportMessageHeader)) app::MessageHead(0);
+                    reinterpret_cast<TransportMessageHeader*>(addr)->setSeq(
+                        std::numeric_limits<HMBDC_SEQ_TYPE>::max());
+                }
+            }
+        }
+        toSendMsgs_.reserve((maxSendBatch_ + 2) * 2 * sendBatchDatagrams_); //double for MemorySeg cases
+        datagrams_.reserve(sendBatchDatagrams_);
+        mmsgs_.resize(sendBatchDatagrams_ + (fecK_ ? fecM_ + 1 : 0));
+        if (fecK_) {
+            fecStripes_.resize(fecM_);
+            for (auto& stripe : fecStripes_) {
+                stripe.acc.resize(mtu_);
+                stripe.table.reserve((fecK_ + fecM_ - 1) / fecM_);
+            }
+            fecOut_.resize((sendBatchDatagrams_ / fecK_ + 2) * fecM_, std::vector<char>(mtu_));
+        }
 
         auto ttl = config_.getExt<int>("ttl");
         if (ttl > 0 && setsockopt(mcFd_.fd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl)) < 0) {
@@ -79,6 +144,48 @@ struct McSendTransport
         hmbdc::app::utils::EpollTask::instance().add(
             hmbdc::app::utils::EpollTask::EPOLLOUT 
                 | hmbdc::app::utils::EpollTask::EPOLLET, mcFd_);
+
+        if (config_.getExt<bool>("nakRepair")) {
+            /// Naks come in on the multicast group, so does the other senders' traffic
+            nakFd_.reset(new udpcast::EpollFd(cfg));
+            uint32_t yes = 1;
+            if (setsockopt(nakFd_->fd, SOL_SOCKET,SO_REUSEADDR, &yes, sizeof(yes)) < 0) {
+                HMBDC_LOG_C("failed to set reuse address errno=", errno);
+            }
+            auto mcAddr = mcAddr_;
+            if (::bind(nakFd_->fd, (struct sockaddr *)&mcAddr, sizeof(mcAddr)) < 0) {
+                HMBDC_THROW(std::runtime_error, "failed to bind for Nak " 
+                    << config_.getExt<std::string>("mcastAddr") << ':'
+                        << cfg.getExt<short>("mcastPort"));
+            }
+            struct ip_mreq mreq;
+            mreq.imr_multiaddr.s_addr = mcAddr_.sin_addr.s_addr;
+            auto iface = 
+                comm::inet::getLocalIpMatchMask(config_.getExt<std::string>("ifaceAddr")).first;
+            mreq.imr_interface.s_addr = inet_addr(iface.c_str());
+            if (setsockopt(nakFd_->fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
+                HMBDC_THROW(std::runtime_error, "failed to join for Nak " 
+                    << config_.getExt<std::string>("mcastAddr") << ':'
+                    << cfg.getExt<short>("mcastPort"));
+            }
+            nakBatch_.reset(new udpcast::RecvBatch(nakFd_->fd
+                , config_.getExt<size_t>("sendBatchDatagrams"), mtu_, false));
+            repairs_.set_capacity(256);
+            recentRepairs_.set_capacity(64);
+            hmbdc::app::utils::EpollTask::instance().add(
+                hmbdc::app::utils::EpollTask::EPOLLIN
+                    | hmbdc::app::utils::EpollTask::EPOLLET, *nakFd_);
+        }
+    }
+
+    /**
+     * @brief tell which Naks are for this sender
+     * 
+     * @param backupAddr the backup tcp address advertised in TypeTagBackupSource
+     */
+    void setNakIdentity(sockaddr_in const& backupAddr) {
+        nakIp_ = backupAddr.sin_addr.s_addr;
+        nakPort_ = ntohs(backupAddr.sin_port);
     }
 
     void startSend(){
@@ -110,6 +217,10 @@ struct McSendTransport
 
 
     void runOnce(size_t sessionCount) HMBDC_RESTRICT {
+        if (hmbdc_unlikely(nakFd_ != nullptr)) {
+            readNaks();
+            sendRepairs();
+        }
         resumeSend(sessionCount);
     }
 
@@ -117,6 +228,41 @@ struct McSendTransport
         buffer_.reset(0);
     }
 
+    /**
+     * @brief max bytes of the messages packed in a datagram
+     */
+    size_t datagramLimit() const {
+        return (gso_ ? mtu_ - PAD_HEAD_SIZE : mtu_) - fecOverhead_;
+    }
+
+    /**
+     * @brief how many Naks for this sender came in so far
+     */
+    size_t nakCount() const {
+        return nakCount_;
+    }
+
+    /**
+     * @brief bytes of the data datagrams covered by FEC parities so far
+     */
+    size_t fecDataBytes() const {
+        return fecDataBytes_;
+    }
+
+    /**
+     * @brief bytes of the FEC parity datagrams sent so far
+     */
+    size_t fecParityBytes() const {
+        return fecParityBytes_;
+    }
+
+    /**
+     * @brief number of the FEC parity datagrams sent so far
+     */
+    size_t fecParityDatagrams() const {
+        return fecParityDatagrams_;
+    }
+
 private:
     size_t maxMessageSize_;
     Buffer& HMBDC_RESTRICT buffer_;
@@ -127,6 +273,8 @@ private:
     msghdr toSend_;
     hmbdc::time::Rater& HMBDC_RESTRICT rater_;
     size_t maxSendBatch_;
+    size_t sendBatchDatagrams_;
+    bool gso_;
     std::vector<std::array<char, sizeof(TransportMessageHeader) 
         + sizeof(app::MessageWrap<TypeTagBackupSource>)>> adBufs_;
     bool adPending_;
@@ -137,49 +285,320 @@ private:
     std::vector<iovec> toSendMsgs_;
     ToCleanupAttQueue& toCleanupAttQueue_;
 
+    /// a udp packet to send - a range in toSendMsgs_
+    struct Datagram {
+        size_t iovBegin;
+        size_t bytes;
+        size_t wasteSize; /// how many messages in buffer_ it carries
+        HMBDC_SEQ_TYPE firstSeq; /// of the messages in buffer_ it carries
+    };
+    std::vector<Datagram> datagrams_;
+    size_t sentDatagrams_ = 0;
+    std::vector<mmsghdr> mmsgs_;
+    /// gso needs every packet but the last one to be exactly mtu_ bytes, 
+    /// padding with a message nobody subscribes to
+    static constexpr size_t PAD_HEAD_SIZE = sizeof(TransportMessageHeader) + sizeof(app::MessageHead);
+    std::vector<std::array<char, PAD_HEAD_SIZE>> padHeads_;
+    std::vector<char> padZeros_;
+
+    void openDatagram() {
+        datagrams_.push_back(Datagram{toSendMsgs_.size(), 0, 0
+            , std::numeric_limits<HMBDC_SEQ_TYPE>::max()});
+    }
+
+    void closeDataDatagram() {
+        auto& d = *datagrams_.rbegin();
+        if (fecK_ && d.wasteSize) {
+            fecAdd(datagrams_.size() - 1);
+        }
+        closeDatagram();
+    }
+
+    void closeDatagram() {
+        auto& d = *datagrams_.rbegin();
+        if (d.iovBegin == toSendMsgs_.size()) {
+            datagrams_.pop_back(); // empty
+        }
+    }
+
+    size_t iovEnd(size_t datagramIndex) const {
+        return datagramIndex + 1 < datagrams_.size()
+            ? datagrams_[datagramIndex + 1].iovBegin : toSendMsgs_.size();
+    }
+
+    /**
+     * @brief send the unsent datagrams in one syscall
+     * @return how many datagrams sent, or -1 with errno set
+     */
+    int sendDatagrams() {
+        if (gso_) {
+            /// one buffer with all but the last datagram padded to mtu_
+            auto& iovs = padded_;
+            iovs.clear();
+            for (auto i = sentDatagrams_; i < datagrams_.size(); ++i) {
+                auto& d = datagrams_[i];
+                iovs.insert(iovs.end(), toSendMsgs_.begin() + d.iovBegin, toSendMsgs_.begin() + iovEnd(i));
+                if (i + 1 != datagrams_.size()) {
+                    auto padLen = mtu_ - d.bytes;
+                    auto padHead = padHeads_[i - sentDatagrams_].data();
+                    reinterpret_cast<TransportMessageHeader*>(padHead)->messagePayloadLen 
+                        = uint16_t(padLen - sizeof(TransportMessageHeader));
+                    iovs.push_back(iovec{padHead, PAD_HEAD_SIZE});
+                    if (padLen > PAD_HEAD_SIZE) {
+                        iovs.push_back(iovec{padZeros_.data(), padLen - PAD_HEAD_SIZE});
+                    }
+                }
+            }
+            toSend_.msg_iov = &iovs[0];
+            toSend_.msg_iovlen = iovs.size();
+            if (sendmsg(mcFd_.fd, &toSend_, MSG_DONTWAIT) < 0) return -1;
+            return int(datagrams_.size() - sentDatagrams_);
+        }
+        auto n = datagrams_.size() - sentDatagrams_;
+        for (auto i = 0u; i < n; ++i) {
+            auto di = sentDatagrams_ + i;
+            auto& h = mmsgs_[i].msg_hdr;
+            h = toSend_;
+            h.msg_iov = &toSendMsgs_[datagrams_[di].iovBegin];
+            h.msg_iovlen = iovEnd(di) - datagrams_[di].iovBegin;
+        }
+        return sendmmsg(mcFd_.fd, &mmsgs_[0], n, MSG_DONTWAIT);
+    }
+    std::vector<iovec> padded_;
+
+    std::unique_ptr<udpcast::EpollFd> nakFd_;
+    std::unique_ptr<udpcast::RecvBatch> nakBatch_;
+    uint32_t nakIp_ = 0;
+    uint16_t nakPort_ = 0;
+    hmbdc::time::Rater repairRater_;
+    hmbdc::time::Duration repairHoldoff_;
+    boost::circular_buffer<std::pair<HMBDC_SEQ_TYPE, size_t>> repairs_;
+    boost::circular_buffer<std::tuple<HMBDC_SEQ_TYPE, size_t, hmbdc::time::SysTime>> recentRepairs_;
+    std::vector<iovec> repairIovs_;
+    size_t nakCount_ = 0;
+
+    void readNaks() {
+        while (nakFd_->isFdReady()) {
+            auto n = nakBatch_->recv(nakFd_->fd);
+            if (n <= 0) {
+                if (n < 0 && !nakFd_->checkErr()) {
+                    HMBDC_LOG_C("recvmmsg failed errno=", errno);
+                }
+                return;
+            }
+            for (auto i = 0; i < n; ++i) {
+                auto p = nakBatch_->packet(i);
+                auto bytes = nakBatch_->len(i);
+                while (bytes >= sizeof(TransportMessageHeader)) {
+                    auto h = reinterpret_cast<TransportMessageHeader*>(p);
+                    auto wireSize = h->wireSize();
+                    if (wireSize > bytes) break;
+                    if (hmbdc_unlikely(h->typeTag() == Nak::typeTag)) {
+                        handleNak(h->template wrapped<Nak>());
+                    }
+                    p += wireSize;
+                    bytes -= wireSize;
+                }
+            }
+        }
+    }
+
+    void handleNak(Nak const& nak) {
+        if (nak.ip != nakIp_ || nak.port != nakPort_) return;
+        nakCount_++;
+        /// only what was multicasted and still kept for the backup channel
+        HMBDC_SEQ_TYPE lo = std::max<HMBDC_SEQ_TYPE>(nak.seq, buffer_.readSeq(1));
+        HMBDC_SEQ_TYPE hi = std::min<HMBDC_SEQ_TYPE>(nak.seq + nak.len, buffer_.readSeq(0));
+        auto now = hmbdc::time::SysTime::now();
+        /// once per range - the other receivers' Naks for it are answered already
+        for (auto const& r : recentRepairs_) {
+            auto s = std::get<0>(r);
+            auto e = s + std::get<1>(r);
+            if (now - std::get<2>(r) < repairHoldoff_ && s <= lo && lo < e) {
+                lo = e;
+            }
+        }
+        if (lo >= hi || repairs_.full()) return;
+        repairs_.push_back(std::make_pair(lo, hi - lo));
+        recentRepairs_.push_back(std::make_tuple(lo, hi - lo, now));
+    }
+
+    void sendRepairs() {
+        while (repairs_.size()) {
+            auto& r = repairs_.front();
+            auto lowest = buffer_.readSeq(1);
+            if (hmbdc_unlikely(r.first < lowest)) { //gone, tcp backup would take care
+                auto skip = std::min<size_t>(r.second, lowest - r.first);
+                r.first += skip;
+                r.second -= skip;
+            }
+            if (!r.second) {
+                repairs_.pop_front();
+                continue;
+            }
+            if (!mcFd_.isFdReady()) return;
+            Buffer::iterator it;
+            buffer_.peek(1, it, it, 0);
+            it.seq_ = r.first;
+            repairIovs_.clear();
+            size_t bytes = 0;
+            size_t count = 0;
+            while (count < r.second && count < maxSendBatch_) {
+                auto item = static_cast<TransportMessageHeader*>(*it);
+                if (bytes + item->wireSize() > mtu_
+                    || !repairRater_.check(item->wireSize())) break;
+                repairRater_.commit();
+                if (hmbdc_unlikely(item->typeTag() == app::MemorySeg::typeTag)) {
+                    repairIovs_.push_back(iovec{(void*)item->wireBytes(), item->wireSize() - item->wireSizeMemorySeg()});
+                    repairIovs_.push_back(iovec{(void*)item->wireBytesMemorySeg(), item->wireSizeMemorySeg()});
+                } else {
+                    repairIovs_.push_back(iovec{(void*)item->wireBytes(), item->wireSize()}); 
+                }
+                bytes += item->wireSize();
+                count++;
+                ++it;
+            }
+            if (!count) return; //rate limited
+            auto mh = toSend_;
+            mh.msg_iov = &repairIovs_[0];
+            mh.msg_iovlen = repairIovs_.size();
+            if (sendmsg(mcFd_.fd, &mh, MSG_DONTWAIT) < 0) {
+                if (!mcFd_.checkErr()) {
+                    HMBDC_LOG_C("sendmsg failed errno=", errno);
+                }
+                return;
+            }
+            r.first += count;
+            r.second -= count;
+        }
+    }
+
+    /// FEC: groups of fecK_ data datagrams, datagram i of a group goes to stripe i % fecM_ 
+    /// and each stripe gets one XOR parity datagram - a burst of up to fecM_ lost 
+    /// datagrams in a group is recoverable
+    size_t fecK_;
+    size_t fecM_;
+    size_t fecOverhead_ = 0;
+    struct FecStripe {
+        std::vector<char> acc;
+        size_t len = 0;
+        std::vector<FecParity::Datagram> table;
+    };
+    std::vector<FecStripe> fecStripes_;
+    size_t fecCount_ = 0;
+    std::vector<std::vector<char>> fecOut_; /// parity datagrams not sent yet
+    size_t fecOutNext_ = 0;
+    size_t fecDataBytes_ = 0;
+    size_t fecParityBytes_ = 0;
+    size_t fecParityDatagrams_ = 0;
+
+    void fecAdd(size_t datagramIndex) {
+        auto const& d = datagrams_[datagramIndex];
+        auto& stripe = fecStripes_[fecCount_ % fecM_];
+        auto acc = stripe.acc.data();
+        for (auto i = d.iovBegin; i < iovEnd(datagramIndex); ++i) {
+            auto p = static_cast<char const*>(toSendMsgs_[i].iov_base);
+            auto len = toSendMsgs_[i].iov_len;
+            for (size_t j = 0; j < len; ++j) {
+                acc[j] ^= p[j];
+            }
+            acc += len;
+        }
+        stripe.len = std::max(stripe.len, d.bytes);
+        stripe.table.emplace_back();
+        auto& entry = *stripe.table.rbegin();
+        entry.firstSeq = d.firstSeq;
+        entry.msgCount = (uint16_t)d.wasteSize;
+        entry.len = (uint16_t)d.bytes;
+        fecDataBytes_ += d.bytes;
+        if (++fecCount_ == fecK_) fecEmit();
+    }
+
+    void fecEmit() {
+        for (auto& stripe : fecStripes_) {
+            if (stripe.table.empty()) continue;
+            auto addr = fecOut_[fecOutNext_++ % fecOut_.size()].data();
+            auto h = new (addr) TransportMessageHeader;
+            auto& parity = (new (addr + sizeof(TransportMessageHeader)) 
+                app::MessageWrap<FecParity>)->template get<FecParity>();
+            parity.datagramCount = (uint16_t)stripe.table.size();
+            parity.parityLen = (uint16_t)stripe.len;
+            memcpy(parity.table(), stripe.table.data()
+                , stripe.table.size() * sizeof(FecParity::Datagram));
+            memcpy(parity.parity(), stripe.acc.data(), stripe.len);
+            auto bytes = size_t(parity.parity() + stripe.len - addr);
+            h->messagePayloadLen = uint16_t(bytes - sizeof(TransportMessageHeader));
+            h->setSeq(std::numeric_limits<HMBDC_SEQ_TYPE>::max());
+            openDatagram();
+            toSendMsgs_.push_back(iovec{addr, bytes});
+            datagrams_.rbegin()->bytes = bytes;
+            fecParityBytes_ += bytes;
+            fecParityDatagrams_++;
+            memset(stripe.acc.data(), 0, stripe.len);
+            stripe.len = 0;
+            stripe.table.clear();
+        }
+        fecCount_ = 0;
+    }
+
     void 
     resumeSend(size_t sessionCount) {
         do {
-            if (hmbdc_likely(toSendMsgs_.size())) {
+            if (hmbdc_likely(sentDatagrams_ < datagrams_.size())) {
                 if (hmbdc_unlikely(!mcFd_.isFdReady())) return;
-
-                toSend_.msg_iov = &(toSendMsgs_[0]);
-                toSend_.msg_iovlen = toSendMsgs_.size();
-                if (sendmsg(mcFd_.fd, &toSend_, MSG_DONTWAIT) < 0) {
+                auto sent = sendDatagrams();
+                if (sent < 0) {
                     if (!mcFd_.checkErr()) {
                         HMBDC_LOG_C("sendmmsg failed errno=", errno);
                     }
                     return; 
-                } else {
-                    buffer_.wasteAfterPeek(0, wasteSize_);
-                    toSendMsgs_.clear();
-                    wasteSize_ = 0;
                 }
+                for (auto i = sentDatagrams_; i < sentDatagrams_ + sent; ++i) {
+                    buffer_.wasteAfterPeek(0, datagrams_[i].wasteSize);
+                }
+                sentDatagrams_ += sent;
+                if (sentDatagrams_ < datagrams_.size()) return; //resume next time
+                datagrams_.clear();
+                toSendMsgs_.clear();
+                sentDatagrams_ = 0;
+                wasteSize_ = 0;
             }
 
-            size_t batchBytes = 0;
             if (hmbdc_unlikely(adPending_)) {
+                openDatagram();
                 for (auto& adBuf : adBufs_) {
                     toSendMsgs_.push_back(iovec{(void*)adBuf.data(), adBuf.size()});
-                    batchBytes += sizeof(adBuf);
+                    datagrams_.rbegin()->bytes += sizeof(adBuf);
                 }
+                closeDatagram();
                 adPending_ = false;
             }
 
-            if (hmbdc_likely(startSending_) && !toSendMsgs_.size()) {
+            if (hmbdc_likely(startSending_) && datagrams_.size() < sendBatchDatagrams_) {
                 Buffer::iterator begin,  end;
-                buffer_.peek(0, begin, end, maxSendBatch_);
+                buffer_.peek(0, begin, end, maxSendBatch_ * sendBatchDatagrams_);
                 if (hmbdc_unlikely(!sessionCount)) {
                     buffer_.wasteAfterPeek(0u, end - begin);
                     begin = end;
                 }
                 auto it = begin;
+                size_t msgCountInDatagram = 0;
+                auto limit = datagramLimit();
+                if (it != end) openDatagram();
                 while (it != end) {
                     void* ptr = *it;
                     auto item = static_cast<TransportMessageHeader*>(ptr);
                     if (hmbdc_unlikely(!rater_.check(item->wireSize()))) break;
-                    batchBytes += item->wireSize();
-                    if (hmbdc_unlikely(batchBytes > mtu_)) break;
+                    auto* d = &*datagrams_.rbegin();
+                    if (hmbdc_unlikely(d->bytes + item->wireSize() > limit
+                        || msgCountInDatagram == maxSendBatch_)) {
+                        if (datagrams_.size() >= sendBatchDatagrams_) break;
+                        closeDataDatagram();
+                        openDatagram();
+                        d = &*datagrams_.rbegin();
+                        msgCountInDatagram = 0;
+                    }
+                    d->bytes += item->wireSize();
                     if (hmbdc_unlikely(item->typeTag() == app::MemorySeg::typeTag)) {
                         toSendMsgs_.push_back(iovec{(void*)item->wireBytes(), item->wireSize() - item->wireSizeMemorySeg()});
                         toSendMsgs_.push_back(iovec{(void*)item->wireBytesMemorySeg(), item->wireSizeMemorySeg()});
@@ -194,21 +613,26 @@ private:
                         }
                         toSendMsgs_.push_back(iovec{(void*)item->wireBytes(), item->wireSize()}); 
                     }
+                    if (!d->wasteSize++) d->firstSeq = it.seq_;
+                    msgCountInDatagram++;
                     seqAlert_->expectSeq = it.seq_ + 1;
                     it++;
 
                     rater_.commit();
                 }
+                if (datagrams_.size()) closeDataDatagram();
                 wasteSize_ = it - begin;
             }
             if (hmbdc_unlikely(seqAlertPending_)) {
-                if (!wasteSize_) {
+                if (!wasteSize_ && datagrams_.size() < sendBatchDatagrams_) {
+                    if (fecCount_) fecEmit(); //idle, do not hold the partial group
+                    openDatagram();
                     toSendMsgs_.push_back(iovec{seqAlertBuf_, sizeof(seqAlertBuf_)});
-                    batchBytes += sizeof(seqAlertBuf_);
+                    datagrams_.rbegin()->bytes += sizeof(seqAlertBuf_);
                 } //else no need to send seq alert
                 seqAlertPending_ = false;
             }
-        } while (hmbdc_likely(toSendMsgs_.size()));
+        } while (hmbdc_likely(datagrams_.size()));
     }
 };
 
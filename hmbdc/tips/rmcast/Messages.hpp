@@ -170,6 +170,62 @@ struct SeqAlert
     }
 };
 
+/**
+ * @class Nak
+ * @brief multicasted by a receiver (nakRepair mode) asking a sender to retransmit a range
+ * @details the sender is identified by its backup tcp address as advertised in
+ * TypeTagBackupSource. other receivers overhear it and hold back their own Nak for the same range
+ */
+struct Nak
+: app::hasTag<457> {
+    uint32_t ip; //in_addr_t, network order
+    XmitEndian<uint16_t> port;
+    XmitEndian<HMBDC_SEQ_TYPE> seq;
+    XmitEndian<uint32_t> len;
+    friend 
+    std::ostream& operator << (std::ostream& os, Nak const & m) {
+        return os << "Nak " << m.seq << ',' << m.len;
+    }
+};
+
+/**
+ * @class FecParity
+ * @brief XOR parity over a stripe of data datagrams (see tx fecK and fecM config) 
+ * so a receiver rebuilds one lost datagram of the stripe without a round trip
+ * @details on the wire it is followed by the datagram table and the parity bytes
+ */
+struct FecParity
+: app::hasTag<458> {
+    struct Datagram {
+        XmitEndian<HMBDC_SEQ_TYPE> firstSeq;
+        XmitEndian<uint16_t> msgCount;
+        XmitEndian<uint16_t> len;
+    };
+    XmitEndian<uint16_t> datagramCount;
+    XmitEndian<uint16_t> parityLen;
+
+    Datagram* table() {
+        return reinterpret_cast<Datagram*>(this + 1);
+    }
+
+    Datagram const* table() const {
+        return reinterpret_cast<Datagram const*>(this + 1);
+    }
+
+    char* parity() {
+        return reinterpret_cast<char*>(table() + datagramCount);
+    }
+
+    char const* parity() const {
+        return reinterpret_cast<char const*>(table() + datagramCount);
+    }
+
+    friend 
+    std::ostream& operator << (std::ostream& os, FecParity const & m) {
+        return os << "FecParity " << m.datagramCount << ',' << m.parityLen;
+    }
+};
+
 static_assert(sizeof(SeqAlert) == sizeof(HMBDC_SEQ_TYPE)
     , "do you have a pack pragma unclosed that influencs the above struct packing unexpectedly?");
 }}}
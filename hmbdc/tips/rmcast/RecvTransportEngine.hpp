@@ -43,7 +43,7 @@ template <typename OutputBuffer, typename AttachmentAllocator>
 struct RecvTransportImpl 
 : RecvTransport
 , hmbdc::time::TimerManager {
-    using MD = hmbdc::app::MessageDispacher<RecvTransportImpl, std::tuple<TypeTagBackupSource>>;
+    using MD = hmbdc::app::MessageDispacher<RecvTransportImpl, std::tuple<TypeTagBackupSource, Nak>>;
 
 /**
  * @brief ctor
@@ -56,7 +56,8 @@ struct RecvTransportImpl
  */
     RecvTransportImpl(hmbdc::app::Config const& cfg, OutputBuffer& outputBuffer)
 	: RecvTransport(cfg)
-    , cmdBuffer_(std::max({sizeof(app::MessageWrap<TypeTagBackupSource>)})
+    , cmdBuffer_(std::max({sizeof(app::MessageWrap<TypeTagBackupSource>)
+            , sizeof(app::MessageWrap<Nak>)})
         , config_.getExt<uint16_t>("cmdBufferSizePower2"))
     , outputBuffer_(outputBuffer)
     , myBackupIp_(inet_addr(hmbdc::comm::inet::getLocalIpMatchMask(
@@ -93,6 +94,11 @@ struct RecvTransportImpl
         cmdBuffer_.wasteAfterPeek(begin, n);
         mcRecvTransport_.runOnce();
         for (auto it = recvSessions_.begin(); it != recvSessions_.end();) {
+            HMBDC_SEQ_TYPE nakSeq;
+            size_t nakLen;
+            if (hmbdc_unlikely(it->second->nakDue(nakSeq, nakLen))) {
+                mcRecvTransport_.sendNak((uint32_t)it->first.first, it->first.second, nakSeq, nakLen);
+            }
             if (hmbdc_unlikely(!it->second->runOnce())) {
                 it->second->stop();
                 cancel(*it->second);
@@ -148,6 +154,16 @@ struct RecvTransportImpl
         } //else ignore
     }
 
+/**
+ * @brief only used by MH - a Nak from a receiver, could be this one
+ */
+    void handleMessageCb(Nak const& n) {
+        auto it = recvSessions_.find(std::make_pair((uint64_t)n.ip, uint16_t(n.port)));
+        if (it != recvSessions_.end()) {
+            it->second->nakOverheard(n.seq, n.len, time::SysTime::now());
+        }
+    }
+
     /**
      * @brief check how many other parties are sending to this engine
      * @return recipient session count are still active
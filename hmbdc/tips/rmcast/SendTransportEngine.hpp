@@ -201,6 +201,23 @@ struct SendTransport
         return asyncBackupSendServer_.readySessionCount();
     }
 
+    /**
+     * @brief the current send rate ceiling in bytes per second
+     * @details it is sendBytesPerSec unless congestionControl is on
+     */
+    size_t sendBytesPerSec() const {
+        return congestionRate_;
+    }
+
+    /**
+     * @brief FEC parity bytes sent relative to the data bytes they cover
+     * @return 0 if FEC is off (tx fecK is 0) or nothing sent yet
+     */
+    double fecOverhead() const {
+        auto data = mcSendTransport_.fecDataBytes();
+        return data ? double(mcSendTransport_.fecParityBytes()) / data : 0;
+    }
+
     template <app::MessageTupleC Messages, typename Node>
     void advertiseFor(Node const& node, uint16_t mod, uint16_t res) {
         std::scoped_lock<std::mutex> g(advertisedTypeTags_.lock);
@@ -215,6 +232,8 @@ private:
     Buffer buffer_;
 
     hmbdc::time::Rater rater_;
+    bool const congestionControl_;
+    hmbdc::time::Rater congestionRater_; /// multicast only pacing when congestionControl is on
     McSendTransport mcSendTransport_;
     std::atomic<size_t> minRecvToStart_;
     hmbdc::time::ReoccuringTimer typeTagAdTimer_;
@@ -229,6 +248,19 @@ private:
     std::atomic<bool> advertisedTypeTagsDirty_ = false;
     TypeTagSetST advertisedTypeTags_;
 
+    /// AIMD send rate control, see congestionControl config
+    hmbdc::time::ReoccuringTimer congestionTimer_;
+    size_t const congestionMaxRate_;
+    size_t const congestionMinRate_;
+    size_t const congestionIncrease_;
+    size_t const congestionBackoffPercent_;
+    size_t congestionRate_;
+    size_t congestionLossSeen_ = 0;
+    size_t congestionProgressSeen_ = 0;
+    bool congestionHold_ = false;
+
+    void adjustSendRate();
+
 private:
     uint16_t
     outBufferSizePower2();
@@ -364,17 +396,27 @@ SendTransport(hmbdc::app::Config cfg
     , config_.getExt<size_t>("sendBytesPerSec")
     , config_.getExt<size_t>("sendBytesBurst")
     , config_.getExt<size_t>("sendBytesBurst") != 0ul)
-, mcSendTransport_(config_, maxMessageSize, buffer_, rater_, toCleanupAttQueue_)
+, congestionControl_(config_.getExt<bool>("congestionControl") && rater_.enabled())
+, congestionRater_(rater_)
+, mcSendTransport_(config_, maxMessageSize, buffer_
+    , congestionControl_ ? congestionRater_ : rater_, toCleanupAttQueue_)
 , minRecvToStart_(config_.getExt<size_t>("minRecvToStart"))
 , typeTagAdTimer_(hmbdc::time::Duration::seconds(config_.getExt<uint32_t>("typeTagAdvertisePeriodSeconds")))
 , lastBackupSeq_(std::numeric_limits<HMBDC_SEQ_TYPE>::max())
 , flushTimer_(hmbdc::time::Duration::microseconds(config_.getExt<uint32_t>("netRoundtripLatencyMicrosec")))
-, maxMemorySegPayloadSize_(std::min(mtu_ - sizeof(TransportMessageHeader) - sizeof(app::MessageHead)
+, maxMemorySegPayloadSize_(std::min(mcSendTransport_.datagramLimit() 
+        - sizeof(TransportMessageHeader) - sizeof(app::MessageHead)
     , TransportMessageHeader::maxPayloadSize() - sizeof(app::MessageHead))
 )
 , waitForSlowReceivers_(config_.getExt<bool>("waitForSlowReceivers")) 
 , asyncBackupSendServer_(config_, buffer_, rater_, toCleanupAttQueue_, outboundSubscriptions_)
-, stopped_(false) { 
+, stopped_(false)
+, congestionTimer_(hmbdc::time::Duration::microseconds(config_.getExt<uint32_t>("recvReportDelayMicrosec")))
+, congestionMaxRate_(config_.getExt<size_t>("sendBytesPerSec"))
+, congestionMinRate_(std::min(config_.getExt<size_t>("congestionMinBytesPerSec"), congestionMaxRate_))
+, congestionIncrease_(config_.getExt<size_t>("congestionIncreaseBytesPerSec"))
+, congestionBackoffPercent_(std::min(config_.getExt<size_t>("congestionBackoffPercent"), size_t(99)))
+, congestionRate_(congestionMaxRate_) { 
     if (maxMessageSize_ > mtu_) {
         HMBDC_THROW(std::out_of_range, "mtu needs to >= " << maxMessageSize_);
     }
@@ -390,6 +432,7 @@ SendTransport(hmbdc::app::Config cfg
     }
 
     toCleanupAttQueue_.set_capacity(buffer_.capacity() + 10);
+    mcSendTransport_.setNakIdentity(asyncBackupSendServer_.localAddr());
     typeTagAdTimer_.setCallback(
         [this](hmbdc::time::TimerManager& tm, hmbdc::time::SysTime const& now) {
             mcSendTransport_.setAdPending();
@@ -404,6 +447,51 @@ SendTransport(hmbdc::app::Config cfg
         }
     );
     schedule(hmbdc::time::SysTime::now(), flushTimer_);
+
+    if (congestionControl_) {
+        congestionTimer_.setCallback(
+            [this](hmbdc::time::TimerManager& tm, hmbdc::time::SysTime const& now) {
+                adjustSendRate();
+            }
+        );
+        schedule(hmbdc::time::SysTime::now(), congestionTimer_);
+    } else if (config_.getExt<bool>("congestionControl")) {
+        HMBDC_LOG_W("congestionControl needs rate control (sendBytesBurst and sendBytesPerSec), ignored");
+    }
+}
+
+/**
+ * @brief AIMD - back off multiplicatively once for each period that saw gap reports or Naks,
+ * go up additively for each period that saw progress reports and no loss
+ * @details one period is held after a back off since the reports lag behind the send.
+ * only the multicast is paced by it, the tcp backup stays on sendBytesPerSec to repair quickly
+ */
+inline
+void
+SendTransport::
+adjustSendRate() {
+    auto loss = asyncBackupSendServer_.gapReportCount() + mcSendTransport_.nakCount();
+    auto progress = asyncBackupSendServer_.progressReportCount();
+    auto rate = congestionRate_;
+    if (loss != congestionLossSeen_) {
+        if (!congestionHold_) {
+            rate = std::max(congestionMinRate_, rate * congestionBackoffPercent_ / 100);
+            congestionHold_ = true;
+        } else {
+            congestionHold_ = false;
+        }
+    } else {
+        congestionHold_ = false;
+        if (progress != congestionProgressSeen_) {
+            rate = std::min(congestionMaxRate_, rate + congestionIncrease_);
+        }
+    }
+    congestionLossSeen_ = loss;
+    congestionProgressSeen_ = progress;
+    if (rate != congestionRate_) {
+        congestionRate_ = rate;
+        congestionRater_.setRate(hmbdc::time::Duration::seconds(1u), rate);
+    }
 }
 
 inline
@@ -411,6 +499,11 @@ void
 SendTransport::
 stop() {
     asyncBackupSendServer_.stop();
+    if (mcSendTransport_.fecParityDatagrams()) {
+        HMBDC_LOG_N("fec parity datagrams=", mcSendTransport_.fecParityDatagrams()
+            , " parity bytes=", mcSendTransport_.fecParityBytes()
+            , " data bytes=", mcSendTransport_.fecDataBytes());
+    }
     buffer_.reset(0);
     buffer_.reset(1);
     stopped_ = true;
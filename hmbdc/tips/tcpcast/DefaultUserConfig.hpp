@@ -19,7 +19,10 @@ constexpr char const*  const DefaultUserConfig = R"|(
     "tx" :
     {
         "hmbdcName"                     : "tcpcast-tx",             "__hmbdcName"                     :"engine thread name",
+        "ioThreadCpuAffinityHex"        : 0,                        "__ioThreadCpuAffinityHex"        :"cpu affinity mask of the io threads, 0 means no affinity",
+        "ioThreads"                     : 0,                        "__ioThreads"                     :"number of threads the tcp sessions are spread over to write to the recipients, 0 means the sessions run on the engine thread - only pays off with spare cores for them",
         "maxSendBatch"                  : 60,                       "__maxSendBatch"                  :"up to how many messages to send in a batch (used as a hint only)",
+        "maxSendBatchBytes"             : 262144,                   "__maxSendBatchBytes"             :"up to how many bytes of queued messages a session writes to its tcp connection in one system call",
         "minRecvToStart"                : 0,                        "__minRecvToStart"                :"start send when there are that many recipients (processes) online, otherwise hold the message in buffer - NOTE: buffer might get full and blocking", 
         "nagling"                       : false,                    "__nagling"                       :"should the tcp channel do nagling",
         "outBufferSizePower2"           : 0,                        "__outBufferSizePower2"           :"2^outBufferSizePower2 is the number of message that can be buffered in the engine, default 0 means automatically calculated based on 1MB as the low bound",
@@ -29,6 +32,7 @@ constexpr char const*  const DefaultUserConfig = R"|(
         "typeTagAdvertisePeriodSeconds" : 1,                        "__typeTagAdvertisePeriodSeconds" :"send engine advertise the message types it covers every so often",
         "ttl"                           : 1,                        "__ttl"                           :"the switch hop number",
         "udpSendBufferBytes"            : 0,                        "__udpSendBufferBytes"            :"OS buffer byte size for outgoing udp, 0 means OS default value",
+        "zeroCopySendBytes"             : 65536,                    "__zeroCopySendBytes"             :"memory attachments of this many bytes or more are sent with MSG_ZEROCOPY, they are released only after the kernel is done with them - 0 turns it off",
         "waitForSlowReceivers"          : true,                     "__waitForSlowReceivers"          :"when true, a slow receiver on the network subscribe to the message might slow down (even block) the sender and other recv engines since the sender needs to wait for it; when false, the slow receiver would be disconnected when it is detected to be slow. in that case the receiver will receive a disconnect message and it by default will reconnect. some messages could be lost before the reconnection is done."    
     },
     "rx" :
@@ -14,6 +14,8 @@
 #include <utility>
 #include <regex>
 
+#include <sys/uio.h>
+
 #include <iostream>
 
 namespace hmbdc { namespace tips { namespace tcpcast {
@@ -202,10 +204,22 @@ private:
             }
             memmove(buf_, bufCur_, filledLen_);
             bufCur_ = buf_;
+            if (hmbdc_unlikely(currTransportHeadFlag_ == hmbdc::app::hasMemoryAttachment::flag
+                && filledLen_)) {
+                continue; //the staged beginning of the attachment goes first
+            }
 
             if (readFd_.isFdReady()) {
-                auto l = recv(readFd_.fd, buf_ + filledLen_, bufSize_ - filledLen_
-                    , MSG_NOSIGNAL|MSG_DONTWAIT);
+                /// an attachment in progress has nothing staged before it - its remaining bytes
+                /// are read in place, what follows it lands in the staging buffer
+                iovec iov[2] = {{nullptr, 0}, {buf_ + filledLen_, bufSize_ - filledLen_}};
+                if (hmbdc_unlikely(currTransportHeadFlag_ == hmbdc::app::hasMemoryAttachment::flag)) {
+                    iov[0] = memoryAttachment_.remaining();
+                }
+                msghdr msg{0};
+                msg.msg_iov = iov[0].iov_len ? iov : iov + 1;
+                msg.msg_iovlen = iov[0].iov_len ? 2 : 1;
+                auto l = recvmsg(readFd_.fd, &msg, MSG_NOSIGNAL|MSG_DONTWAIT);
                 if (hmbdc_unlikely(l < 0)) {
                     if (hmbdc_unlikely(!readFd_.checkErr())) {
                         HMBDC_LOG_C("recv failed errno=", errno);
@@ -215,12 +229,14 @@ private:
                     HMBDC_LOG_W("peer dropped:", id());
                     return false;
                 } else {
-                    filledLen_ += l;
+                    filledLen_ += l - memoryAttachment_.wrote(std::min<size_t>(l, iov[0].iov_len));
                 }
             } else {
                 return true; //has done what can be done
             }
-        } while (filledLen_);
+        } while (filledLen_ 
+            || (currTransportHeadFlag_ == hmbdc::app::hasMemoryAttachment::flag
+                && memoryAttachment_.writeDone()));
         return true;
     }
 
@@ -271,6 +287,21 @@ private:
             return wl;
         }
 
+        /**
+         * @brief where the rest of the attachment goes, empty if it is discarded
+         */
+        iovec remaining() const {
+            return addr_ ? iovec{addr_ + len_, fullLen_ - len_} : iovec{nullptr, 0};
+        }
+
+        /**
+         * @brief account for l bytes read directly into remaining()
+         */
+        size_t wrote(size_t l) {
+            len_ += l;
+            return l;
+        }
+
         void close() {
             addr_ = nullptr;
             fullLen_ = 0;
@@ -7,11 +7,16 @@
 #include "hmbdc/time/Time.hpp"
 #include "hmbdc/pattern/MonoLockFreeBuffer.hpp"
 #include "hmbdc/comm/inet/Misc.hpp"
+#include "hmbdc/os/Thread.hpp"
 
 #include <unordered_set>
 #include <memory>
 #include <utility>
 #include <iostream>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <thread>
 
 #include <netinet/tcp.h>
 
@@ -27,7 +32,10 @@ struct SendServer {
     , serverFd_(cfg)
     , serverAddr_(serverFd_.localAddr)
     , maxSendBatch_(config_.getExt<size_t>("maxSendBatch"))
-    , outboundSubscriptions_(outboundSubscriptions) {
+    , maxSendBatchBytes_(config_.getExt<size_t>("maxSendBatchBytes"))
+    , zeroCopySendBytes_(config_.getExt<size_t>("zeroCopySendBytes"))
+    , outboundSubscriptions_(outboundSubscriptions)
+    , ioThreads_(config_.getExt<size_t>("ioThreads")) {
         if (listen(serverFd_.fd, 10) < 0) {
             HMBDC_THROW(std::runtime_error, "failed to listen, errno=" << errno);
         }
@@ -35,6 +43,41 @@ struct SendServer {
             hmbdc::app::utils::EpollTask::EPOLLIN
                 | hmbdc::app::utils::EpollTask::EPOLLET, serverFd_);
         toSendQueue_.set_capacity(toSendQueueMaxSize);
+        for (auto i = 0u; i < std::max(ioThreads_, size_t(1)); ++i) {
+            shards_.emplace_back(new Shard);
+        }
+        auto cpuAffinity = config_.getHex<uint64_t>("ioThreadCpuAffinityHex");
+        for (auto i = 0u; i < ioThreads_; ++i) {
+            auto name = (config_.getExt<std::string>("hmbdcName") + "-io" + std::to_string(i)).substr(0, 15);
+            shards_[i]->thread = std::thread([this, i, name, cpuAffinity]() {
+                try {
+                    os::configureCurrentThread(name.c_str(), cpuAffinity);
+                } catch (std::exception const& e) {
+                    HMBDC_LOG_W(name, ": ", e.what());
+                }
+                auto& shard = *shards_[i];
+                while (!stopped_.load(std::memory_order_relaxed)) {
+                    auto minSeq = shard.minSeq.load(std::memory_order_relaxed);
+                    try {
+                        runShard(shard);
+                    } catch (std::exception const& e) {
+                        HMBDC_LOG_C(name, ": ", e.what());
+                    }
+                    if (minSeq == shard.minSeq.load(std::memory_order_relaxed)) {
+                        std::this_thread::yield(); //no progress - caught up or waiting for the sockets
+                    }
+                }
+            });
+        }
+    }
+
+    SendServer(SendServer const&) = delete;
+    SendServer& operator = (SendServer const&) = delete;
+    ~SendServer() {
+        stopped_ = true;
+        for (auto& shard : shards_) {
+            if (shard->thread.joinable()) shard->thread.join();
+        }
     }
 
     void advertisingMessages(TypeTagSetST& tts) {
@@ -61,8 +104,9 @@ struct SendServer {
     void queue(uint16_t tag
         , ToSend && toSend
         , size_t toSendByteSize
-        , hmbdc::pattern::MonoLockFreeBuffer::iterator it) {
-        toSendQueue_.push_back(std::forward_as_tuple(tag, std::forward<ToSend>(toSend), toSendByteSize, it));
+        , hmbdc::pattern::MonoLockFreeBuffer::iterator it
+        , int fileFd = -1) {
+        toSendQueue_.push_back(ToSendQueue::Entry(tag, std::forward<ToSend>(toSend), toSendByteSize, it, fileFd));
     }
 
     /**
@@ -78,48 +122,30 @@ struct SendServer {
     hmbdc::pattern::MonoLockFreeBuffer::iterator runOnce(hmbdc::pattern::MonoLockFreeBuffer::iterator begin
         , hmbdc::pattern::MonoLockFreeBuffer::iterator end) HMBDC_RESTRICT {
         doAccept();
-        if (sessions_.size() == 0) {
-            toSendQueue_.clear();
-            return end;
-        }
+        if (!ioThreads_) runShard(*shards_[0]);
         //nothing to retire by default
         auto newStartIt = begin;
-
-        auto minIndex = toSendQueue_.size();
-        for (auto it = sessions_.begin(); it != sessions_.end();) {
-            if (minIndex > (*it)->toSendQueueIndex_) {
-                minIndex = (*it)->toSendQueueIndex_;
-            }
-            if (hmbdc_unlikely(!(*it)->runOnce())) {
-                sessions_.erase(it++);
-            } else {
-                it++;
-            }
-        }
-        if (minIndex) {
-            newStartIt = std::get<3>(toSendQueue_[minIndex - 1]);
-            toSendQueue_.erase_begin(minIndex);
-            for (auto it = sessions_.begin(); it != sessions_.end(); ++it) {
-                (*it)->toSendQueueIndex_ -= minIndex;
-            }
+        auto minSeq = minShardSeq();
+        if (minSeq > retiredSeq_) {
+            newStartIt = std::get<3>(toSendQueue_[minSeq - 1]);
+            retiredSeq_ = minSeq;
         }
-
         return newStartIt;
     }
 
     size_t readySessionCount() const {
         size_t res = 0;
-        for (auto const& s : sessions_) {
-            if (s->ready()) res++;
+        for (auto const& shard : shards_) {
+            res += shard->readyCount.load(std::memory_order_relaxed);
         }
         return res;
     }
 
     void killSlowestSession() {
-        for (auto it = sessions_.begin(); it != sessions_.end(); ++it) {
-            if (0 == (*it)->toSendQueueIndex_) {
-                HMBDC_LOG_C((*it)->id(), " too slow, dropping");
-                sessions_.erase(it);
+        auto minSeq = minShardSeq();
+        for (auto& shard : shards_) {
+            if (shard->minSeq.load(std::memory_order_acquire) == minSeq) {
+                shard->killSlowest = true;
                 break;
             }
         }
@@ -148,24 +174,104 @@ private:
             }
             try {
                 auto s = std::make_shared<SendSession>(
-                    conn, toSendQueue_, maxSendBatch_, outboundSubscriptions_);
-                sessions_.insert(s);
+                    conn, toSendQueue_, maxSendBatch_, maxSendBatchBytes_, zeroCopySendBytes_
+                    , subscriberIndex_, outboundSubscriptions_);
+                auto& shard = *shards_[nextShard_++ % shards_.size()];
+                std::scoped_lock<std::mutex> g(shard.lock);
+                if (shard.adopted.load(std::memory_order_acquire) 
+                    == shard.accepted.load(std::memory_order_relaxed)) {
+                    shard.pendingSeq = s->doneSeq();
+                }
+                shard.pending.push_back(s);
+                shard.accepted.fetch_add(1, std::memory_order_release);
             } catch (std::exception const& e) {
                 HMBDC_LOG_C(e.what());
             }
         }
     }
     
-    hmbdc::app::Config const& config_;
     using Sessions = std::unordered_set<SendSession::ptr>;
-    Sessions sessions_;
+    /// a group of sessions driven by the same thread - one of the io threads 
+    /// or the engine thread when ioThreads is 0
+    struct Shard {
+        Sessions sessions;
+        std::mutex lock;
+        std::vector<SendSession::ptr> pending; /// accepted, not taken in by the shard yet
+        std::atomic<size_t> accepted{0}; /// sessions ever put in pending
+        std::atomic<size_t> adopted{0}; /// of the above, the ones covered by minSeq
+        size_t adopting = 0; /// shard thread only
+        size_t pendingSeq = 0; /// engine thread only - start seq of the oldest pending session
+        std::atomic<size_t> minSeq{0}; /// all sessions are done with toSendQueue_ before it
+        std::atomic<size_t> readyCount{0};
+        std::atomic<bool> killSlowest{false};
+        std::thread thread;
+    };
+
+    void runShard(Shard& shard) {
+        if (hmbdc_unlikely(shard.accepted.load(std::memory_order_acquire) != shard.adopting)) {
+            std::unique_lock<std::mutex> g(shard.lock, std::try_to_lock);
+            if (!g.owns_lock()) return; //next time
+            shard.sessions.insert(shard.pending.begin(), shard.pending.end());
+            shard.pending.clear();
+            shard.adopting = shard.accepted.load(std::memory_order_relaxed);
+        }
+        auto minSeq = toSendQueue_.size();
+        size_t readyCount = 0;
+        for (auto it = shard.sessions.begin(); it != shard.sessions.end();) {
+            if (hmbdc_unlikely(!(*it)->runOnce())) {
+                shard.sessions.erase(it++);
+            } else {
+                minSeq = std::min(minSeq, (*it)->doneSeq());
+                if ((*it)->ready()) readyCount++;
+                it++;
+            }
+        }
+        if (hmbdc_unlikely(shard.killSlowest.exchange(false, std::memory_order_relaxed))) {
+            for (auto it = shard.sessions.begin(); it != shard.sessions.end(); ++it) {
+                if (minSeq == (*it)->doneSeq()) {
+                    HMBDC_LOG_C((*it)->id(), " too slow, dropping");
+                    shard.sessions.erase(it);
+                    break;
+                }
+            }
+        }
+        shard.readyCount.store(readyCount, std::memory_order_relaxed);
+        shard.minSeq.store(minSeq, std::memory_order_release);
+        shard.adopted.store(shard.adopting, std::memory_order_release);
+    }
+
+    /**
+     * @brief the seq all sessions are done with toSendQueue_ before - called in engine thread
+     * @details sessions not yet covered by their shard's minSeq hold on from the oldest pending one
+     */
+    size_t minShardSeq() const {
+        auto res = toSendQueue_.size();
+        for (auto const& shard : shards_) {
+            auto adopted = shard->adopted.load(std::memory_order_acquire);
+            res = std::min(res, shard->minSeq.load(std::memory_order_acquire));
+            if (adopted != shard->accepted.load(std::memory_order_relaxed)) {
+                res = std::min(res, shard->pendingSeq);
+            }
+        }
+        return res;
+    }
+
+    hmbdc::app::Config const& config_;
     ToSendQueue toSendQueue_; 
     EpollFd serverFd_;
     sockaddr_in& serverAddr_;
     mutable std::vector<TypeTagSource> advertisingMessages_;
 
     size_t maxSendBatch_;
+    size_t maxSendBatchBytes_;
+    size_t zeroCopySendBytes_;
     TypeTagSet& outboundSubscriptions_;
+    TypeTagSubscriberIndex subscriberIndex_; /// shared by the sessions in shards_
+    size_t ioThreads_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    size_t nextShard_ = 0;
+    size_t retiredSeq_ = 0;
+    std::atomic<bool> stopped_{false};
 };
 } //sendserver_detail
 using SendServer = sendserver_detail::SendServer;
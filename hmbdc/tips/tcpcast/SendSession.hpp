@@ -10,13 +10,17 @@
 #include "hmbdc/comm/inet/Misc.hpp"
 
 #include <boost/lexical_cast.hpp>
-#include <boost/circular_buffer.hpp>
 
 #include <random>
+#include <atomic>
 #include <memory>
 #include <utility>
 #include <iostream>
+#include <deque>
 #include <fcntl.h>
+#include <sys/uio.h>
+#include <sys/sendfile.h>
+#include <linux/errqueue.h>
 
 namespace hmbdc { namespace tips { namespace tcpcast {
 
@@ -25,30 +29,79 @@ struct SendServer;
 }
 
 using ToSend = std::vector<iovec>;
-using ToSendQueue = boost::circular_buffer<std::tuple<uint16_t //TypeTag
-    , ToSend
-    , size_t //total bytes above
-    , hmbdc::pattern::MonoLockFreeBuffer::iterator //end iterator
-    >
->;
+
+/**
+ * @brief what is queued for the sessions to send, indexed by an ever increasing seq
+ * @details one thread pushes, the sessions (possibly on other threads) read from 
+ * their own seq up to size(). the pushing side makes sure an entry is not overwritten 
+ * before all sessions are done with it
+ */
+struct ToSendQueue {
+    using Entry = std::tuple<uint16_t //TypeTag
+        , ToSend
+        , size_t //total bytes above
+        , hmbdc::pattern::MonoLockFreeBuffer::iterator //end iterator
+        , int //fd of the file mapped attachment - sent by sendfile, -1 for none
+    >;
+
+    void set_capacity(size_t capacity) {
+        size_t cap = 1;
+        while (cap < capacity) cap <<= 1;
+        entries_.resize(cap);
+        mask_ = cap - 1;
+    }
+
+    Entry const& operator[](size_t seq) const {
+        return entries_[seq & mask_];
+    }
+
+    /**
+     * @brief seq of the next entry to be pushed
+     */
+    size_t size() const {
+        return end_.load(std::memory_order_acquire);
+    }
+
+    void push_back(Entry&& entry) {
+        auto seq = end_.load(std::memory_order_relaxed);
+        entries_[seq & mask_] = std::move(entry);
+        end_.store(seq + 1, std::memory_order_release);
+    }
+
+private:
+    std::vector<Entry> entries_;
+    size_t mask_ = 0;
+    std::atomic<size_t> end_{0};
+};
 
 namespace sendsession_detail {
 
 struct SendSession {
     using ptr = std::shared_ptr<SendSession>;
     SendSession(int fd
-        , ToSendQueue & toSendQueue
+        , ToSendQueue const& toSendQueue
         , size_t maxSendBatch
+        , size_t maxSendBatchBytes
+        , size_t zeroCopySendBytes
+        , TypeTagSubscriberIndex& subscriberIndex
         , TypeTagSet& outboundSubscriptions)
     : readLen_(0)
     , ready_(false) 
     , toSendQueue_(toSendQueue)
-    , toSendQueueIndex_(0)
+    , toSendQueueIndex_(toSendQueue.size())
     , msghdr_{0}
     , msghdrRelic_{0}
     , msghdrRelicSize_(0)
+    , relicEntries_(0)
+    , maxSendBatchBytes_(maxSendBatchBytes)
+    , zeroCopySendBytes_(zeroCopySendBytes)
+    , relicZeroCopy_(false)
+    , zeroCopyFrontId_(0)
+    , subscriberIndex_(subscriberIndex)
     , outboundSubscriptions_(outboundSubscriptions) {
-        msghdrRelic_.msg_iov = new iovec[maxSendBatch * 2]; //double for attachment
+        auto maxIov = std::max(maxSendBatch * 2, size_t(UIO_MAXIOV)); //double for attachment
+        msghdrRelic_.msg_iov = new iovec[maxIov];
+        gathered_.reserve(maxIov);
         auto addrPort = hmbdc::comm::inet::getPeerIpPort(fd);
         id_ = addrPort.first + ":" + std::to_string(addrPort.second);
         auto forRead = dup(fd);
@@ -61,9 +114,21 @@ struct SendSession {
             hmbdc::app::utils::EpollTask::EPOLLIN
                 | hmbdc::app::utils::EpollTask::EPOLLET, readFd_);
         writeFd_.fd = fd;
+        auto flags = fcntl(fd, F_GETFL, 0);
+        if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) { //for sendfile
+            HMBDC_THROW(std::runtime_error, "fcntl failed errno=" << errno);
+        }
+        if (zeroCopySendBytes_) {
+            int yes = 1;
+            if (setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &yes, sizeof(yes)) < 0) {
+                HMBDC_LOG_W(id_, " SO_ZEROCOPY not supported, errno=", errno);
+                zeroCopySendBytes_ = 0;
+            }
+        }
         hmbdc::app::utils::EpollTask::instance().add(
             hmbdc::app::utils::EpollTask::EPOLLOUT
                 | hmbdc::app::utils::EpollTask::EPOLLET, writeFd_);
+        slot_ = subscriberIndex_.addSubscriber();
         HMBDC_LOG_N("SendSession started: ", id());
     }
 
@@ -71,19 +136,21 @@ struct SendSession {
     SendSession(SendSession const&) = delete;
     SendSession& operator = (SendSession const&) = delete;
     ~SendSession() {
-        clientSubscriptions_.exportTo([this](uint16_t tag, auto&&) {
+        subscriberIndex_.exportTo(slot_, [this](uint16_t tag) {
             outboundSubscriptions_.sub(tag);
         });
+        subscriberIndex_.removeSubscriber(slot_);
         delete [] msghdrRelic_.msg_iov;
         HMBDC_LOG_N("SendSession retired: ", id());
     }
 
     bool runOnce() HMBDC_RESTRICT {
         if (hmbdc_unlikely(!doRead())) return false;
+        if (hmbdc_unlikely(zeroCopyPending_.size())) reapZeroCopy();
         if (hmbdc_unlikely(writeFd_.isFdReady() && msghdrRelicSize_)) {
-            auto l = sendmsg(writeFd_.fd, &msghdrRelic_, MSG_NOSIGNAL|MSG_DONTWAIT);
+            auto l = send(msghdrRelic_, relicZeroCopy_);
             if (hmbdc_unlikely(l < 0)) {
-                if (!writeFd_.checkErr()) {
+                if (!zeroCopyBlocked(relicZeroCopy_) && !writeFd_.checkErr()) {
                     HMBDC_LOG_C("sendmsg failed errno=", errno);
                     return false;
                 }
@@ -94,29 +161,63 @@ struct SendSession {
                 comm::inet::extractRelicTo(msghdrRelic_, msghdrRelic_, l);
                 return true;
             } else {
-                toSendQueueIndex_++;
+                toSendQueueIndex_ += relicEntries_;
             }
         }
-        for (; !msghdrRelicSize_ && writeFd_.isFdReady() 
-            && toSendQueueIndex_ != toSendQueue_.size();) {
-            if (clientSubscriptions_.check(std::get<0>(toSendQueue_[toSendQueueIndex_]))) {
-                msghdr_.msg_iov = &(std::get<1>(toSendQueue_[toSendQueueIndex_])[0]);
-                msghdr_.msg_iovlen = std::get<1>(toSendQueue_[toSendQueueIndex_]).size();
-                auto l = sendmsg(writeFd_.fd, &msghdr_, MSG_NOSIGNAL|MSG_DONTWAIT);
+        while (!msghdrRelicSize_ && writeFd_.isFdReady() 
+            && toSendQueueIndex_ != toSendQueue_.size()) {
+            /// all the consecutive subscribed entries go in one sendmsg
+            gathered_.clear();
+            size_t bytes = 0;
+            size_t entries = 0;
+            bool zeroCopy = false;
+            bool fileEntry = fileOffset_ != 0; //one in progress goes on regardless of subscriptions
+            auto end = toSendQueue_.size();
+            for (auto i = toSendQueueIndex_; !fileEntry && i != end; ++i, ++entries) {
+                auto const& entry = toSendQueue_[i];
+                if (!subscriberIndex_.check(std::get<0>(entry), slot_)) continue;
+                if (hmbdc_unlikely(std::get<4>(entry) >= 0)) {
+                    fileEntry = true; //goes on its own
+                    break;
+                }
+                auto const& iovs = std::get<1>(entry);
+                if (gathered_.size() 
+                    && (gathered_.size() + iovs.size() > size_t(UIO_MAXIOV)
+                        || bytes + std::get<2>(entry) > maxSendBatchBytes_)) break;
+                gathered_.insert(gathered_.end(), iovs.begin(), iovs.end());
+                bytes += std::get<2>(entry);
+                if (zeroCopySendBytes_ && !zeroCopy && iovs.size() > 1) { //has attachments
+                    for (auto const& iov : iovs) {
+                        zeroCopy = zeroCopy || iov.iov_len >= zeroCopySendBytes_;
+                    }
+                }
+            }
+            if (gathered_.size()) {
+                msghdr_.msg_iov = &gathered_[0];
+                msghdr_.msg_iovlen = gathered_.size();
+                auto l = send(msghdr_, zeroCopy);
                 if (hmbdc_unlikely(l < 0)) {
-                    if (!writeFd_.checkErr()) {
+                    if (!zeroCopyBlocked(zeroCopy) && !writeFd_.checkErr()) {
                         HMBDC_LOG_C("sendmsg failed errno=", errno);
                         return false;
                     }
                     return true;
                 }
-                msghdrRelicSize_ = std::get<2>(toSendQueue_[toSendQueueIndex_]) - size_t(l);
+                msghdrRelicSize_ = bytes - size_t(l);
                 if (hmbdc_unlikely(msghdrRelicSize_)) {
                     comm::inet::extractRelicTo(msghdrRelic_, msghdr_, l);
+                    relicEntries_ = entries;
+                    relicZeroCopy_ = zeroCopy;
                     return true;
                 }
             }
-            toSendQueueIndex_++;
+            toSendQueueIndex_ += entries;
+            if (hmbdc_unlikely(fileEntry && !gathered_.size())) {
+                auto res = sendFileEntry(toSendQueue_[toSendQueueIndex_]);
+                if (res < 0) return false;
+                if (res == 0) return true;
+                toSendQueueIndex_++;
+            }
         }
         return true;
     }
@@ -129,7 +230,116 @@ struct SendSession {
         return ready_;
     }
 
+    /**
+     * @brief the seq this session is done with toSendQueue_ before
+     * @details entries sent with MSG_ZEROCOPY are only done when the kernel says so
+     */
+    size_t doneSeq() const {
+        return zeroCopyPending_.size() ? zeroCopyPending_.front().first : toSendQueueIndex_;
+    }
+
 private:
+    ssize_t send(msghdr const& msg, bool zeroCopy) HMBDC_RESTRICT {
+        auto l = sendmsg(writeFd_.fd, &msg
+            , MSG_NOSIGNAL | MSG_DONTWAIT | (zeroCopy ? MSG_ZEROCOPY : 0));
+        if (zeroCopy && l > 0) {
+            /// the kernel numbers the zero copy sends from 0, one per call that sent bytes
+            zeroCopyPending_.emplace_back(toSendQueueIndex_, false);
+        }
+        return l;
+    }
+
+    /**
+     * @brief send an entry of a message and its file mapped attachment - the message 
+     * goes by sendmsg, the attachment by sendfile from the file's page cache
+     * @details a partially sent message is finished by the relic
+     * @return 1 when all sent, 0 to be continued, -1 for error
+     */
+    int sendFileEntry(ToSendQueue::Entry const& entry) {
+        auto const& iovs = std::get<1>(entry);
+        if (!fileOffset_) {
+            msghdr_.msg_iov = const_cast<iovec*>(&iovs[0]);
+            msghdr_.msg_iovlen = 1;
+            auto l = sendmsg(writeFd_.fd, &msghdr_, MSG_NOSIGNAL | MSG_DONTWAIT | MSG_MORE);
+            if (hmbdc_unlikely(l < 0)) {
+                if (!writeFd_.checkErr()) {
+                    HMBDC_LOG_C("sendmsg failed errno=", errno);
+                    return -1;
+                }
+                return 0;
+            }
+            fileOffset_ = 1; //message is handed to the kernel
+            msghdrRelicSize_ = iovs[0].iov_len - size_t(l);
+            if (hmbdc_unlikely(msghdrRelicSize_)) {
+                comm::inet::extractRelicTo(msghdrRelic_, msghdr_, l);
+                relicEntries_ = 0;
+                relicZeroCopy_ = false;
+                return 0;
+            }
+        }
+        auto fileLen = iovs[1].iov_len;
+        while (fileOffset_ - 1 != fileLen) {
+            off_t off = fileOffset_ - 1;
+            auto l = sendfile(writeFd_.fd, std::get<4>(entry), &off, fileLen - (fileOffset_ - 1));
+            if (hmbdc_unlikely(l <= 0)) {
+                if (l == 0) {
+                    HMBDC_LOG_C("file shrank while being sent");
+                    return -1;
+                }
+                if (!writeFd_.checkErr()) {
+                    HMBDC_LOG_C("sendfile failed errno=", errno);
+                    return -1;
+                }
+                return 0;
+            }
+            fileOffset_ += size_t(l);
+        }
+        fileOffset_ = 0;
+        return 1;
+    }
+
+    /**
+     * @brief a zero copy send fails with ENOBUFS when the socket's pinned memory budget
+     * is used up - wait for completions instead of treating it as an error
+     */
+    bool zeroCopyBlocked(bool zeroCopy) const {
+        return zeroCopy && errno == ENOBUFS;
+    }
+
+    /**
+     * @brief pick up the MSG_ZEROCOPY completions from the socket error queue
+     */
+    void reapZeroCopy() {
+        if (hmbdc_unlikely(writeFd_.fd < 0)) return;
+        char control[CMSG_SPACE(sizeof(sock_extended_err)) * 8];
+        while (true) {
+            msghdr msg{0};
+            msg.msg_control = control;
+            msg.msg_controllen = sizeof(control);
+            if (recvmsg(writeFd_.fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) break;
+            for (auto cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)) {
+                if (!((cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR)
+                    || (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR))) continue;
+                auto err = reinterpret_cast<sock_extended_err const*>(CMSG_DATA(cm));
+                if (err->ee_errno || err->ee_origin != SO_EE_ORIGIN_ZEROCOPY) continue;
+                for (auto id = err->ee_info; ; ++id) { //[ee_info, ee_data]
+                    auto i = uint32_t(id - zeroCopyFrontId_);
+                    if (i < zeroCopyPending_.size()) zeroCopyPending_[i].second = true;
+                    if (id == err->ee_data) break;
+                }
+                if (hmbdc_unlikely((err->ee_code & SO_EE_CODE_ZEROCOPY_COPIED)
+                    && zeroCopySendBytes_)) {
+                    HMBDC_LOG_N(id_, " kernel copied the zero copy send, stop asking for it");
+                    zeroCopySendBytes_ = 0;
+                }
+            }
+        }
+        while (zeroCopyPending_.size() && zeroCopyPending_.front().second) {
+            zeroCopyPending_.pop_front();
+            zeroCopyFrontId_++;
+        }
+    }
+
     bool 
     doRead() HMBDC_RESTRICT {
         if (hmbdc_unlikely(readFd_.isFdReady())) {
@@ -152,13 +362,13 @@ private:
                     ready_ = true;
                 } else if (data_[0] == '+') {
                     auto tag = (uint16_t)std::stoi(t);
-                    if (clientSubscriptions_.set(tag)) {
+                    if (subscriberIndex_.set(tag, slot_)) {
                         HMBDC_LOG_N(id_, " add outboundSubscriptions ", tag);
                         outboundSubscriptions_.add(tag);
                     }
                 } else if (data_[0] == '-') {
                     auto tag = (uint16_t)std::stoi(t);
-                    if (clientSubscriptions_.unset(tag)) {
+                    if (subscriberIndex_.unset(tag, slot_)) {
                         HMBDC_LOG_N(id_, " drop outboundSubscriptions ", tag);
                         outboundSubscriptions_.sub(tag);
                     }
@@ -182,13 +392,25 @@ private:
     bool ready_;
 
     friend struct hmbdc::tips::tcpcast::sendserver_detail::SendServer;
-    ToSendQueue& toSendQueue_;
-    ToSendQueue::size_type toSendQueueIndex_;
+    ToSendQueue const& toSendQueue_;
+    size_t toSendQueueIndex_; /// seq of the next entry in toSendQueue_
     msghdr msghdr_;
     msghdr msghdrRelic_;
     size_t msghdrRelicSize_;
+    size_t relicEntries_; /// how many toSendQueue_ entries the relic finishes
+    size_t fileOffset_ = 0; /// 1 + file bytes sent for the entry in sendFileEntry, 0 if not started
+    size_t maxSendBatchBytes_;
+    ToSend gathered_;
+    size_t zeroCopySendBytes_; /// attachments this big or bigger go MSG_ZEROCOPY, 0 is off
+    bool relicZeroCopy_;
+    /// one per zero copy send not completed yet: the seq it started from, completed or not
+    /// - once the session is gone the kernel could still be reading the attachments 
+    /// in there, but it keeps the pages pinned and the connection is going away anyway
+    std::deque<std::pair<size_t, bool>> zeroCopyPending_;
+    uint32_t zeroCopyFrontId_; /// kernel id of zeroCopyPending_.front()
 
-    TypeTagSet clientSubscriptions_;
+    TypeTagSubscriberIndex& subscriberIndex_;
+    size_t slot_; /// this session's bit in subscriberIndex_
     TypeTagSet& outboundSubscriptions_;
 };
 } //sendsession_detail
@@ -290,25 +290,26 @@ runOnce() HMBDC_RESTRICT {
         if (hmbdc_unlikely(!rater_.check(item->wireSize()))) break;
         if (hmbdc_unlikely(!item->flag 
             && toSendByteSize + item->wireSize() > mtu_)) break;
-        it++;
-        if (hmbdc_unlikely(!currentTypeTag)) {
-            currentTypeTag = item->typeTag();
-            toSendByteSize = item->wireSize();
-            toSend_.push_back(iovec{ptr, item->wireSize()});
-        } else if (item->typeTag() == currentTypeTag) {          
-            toSendByteSize += item->wireSize();
-            toSend_.push_back(iovec{ptr, item->wireSize()});
-        } else {
+        /// a file mapped attachment is sent by sendfile - its message goes in an entry by itself
+        auto fileFd = hmbdc_unlikely(item->flag == app::hasMemoryAttachment::flag)
+            ? item->wrapped<app::hasMemoryAttachment>().mappedFileFd() : -1;
+        if (currentTypeTag 
+            && (item->typeTag() != currentTypeTag || hmbdc_unlikely(fileFd >= 0))) {
             server_->queue(currentTypeTag
                 , std::move(toSend_)
                 , toSendByteSize
                 , it);
             toSend_.clear();
-
+            currentTypeTag = 0;
+        }
+        it++;
+        if (hmbdc_unlikely(!currentTypeTag)) {
             currentTypeTag = item->typeTag();
             toSendByteSize = item->wireSize();
-            toSend_.push_back(iovec{ptr, item->wireSize()});
+        } else {
+            toSendByteSize += item->wireSize();
         }
+        toSend_.push_back(iovec{ptr, item->wireSize()});
 
         if (hmbdc_unlikely(item->flag == app::hasMemoryAttachment::flag)) {
             auto& a = item->wrapped<app::hasMemoryAttachment>();
@@ -316,6 +317,16 @@ runOnce() HMBDC_RESTRICT {
             toSendByteSize += a.len;
         }
         rater_.commit();
+        if (hmbdc_unlikely(fileFd >= 0)) {
+            server_->queue(currentTypeTag
+                , std::move(toSend_)
+                , toSendByteSize
+                , it
+                , fileFd);
+            toSend_.clear();
+            currentTypeTag = 0;
+            toSendByteSize = 0;
+        }
     }
 
     if (toSend_.size()) {
@@ -27,8 +27,10 @@ constexpr char const*  const DefaultUserConfig = R"|(
     "rx" :                               
     {
         "hmbdcName"             : "udpcast-rx",         "__hmbdcName"               :"engine thread name",
+        "recvBatchDatagrams"    : 16,                   "__recvBatchDatagrams"      :"up to how many udp packets to read in one recvmmsg system call",
         "udpcastListenAddr"     : "232.43.212.234",     "__udpcastListenAdd"        :"the receive engine listen to this address for messages - it can be set to ifaceAddr to listen to unicast UDP messages instead of a multicast address",
         "udpcastListenPort"     : 4321,                 "__udpcastListenPort"       :"the receive engine listen to this UDP port for messages",
+        "udpGro"                : false,                "__udpGro"                  :"turn on UDP_GRO so the kernel can hand over several coalesced packets in one read - needs linux 5.0+, ignored if not supported",
         "udpRecvBufferBytes"    : 0,                    "__udpRecvBufferBytes"      :"OS buffer byte size for incoming udp, 0 means OS default value"
     }
 }
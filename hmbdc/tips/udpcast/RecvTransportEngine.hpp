@@ -40,8 +40,11 @@ struct RecvTransportImpl
         , cfg.resetSection("rx", false)))
     , outputBuffer_(outputBuffer)
     , maxItemSize_(outputBuffer.maxItemSize())
-    , buf_(new char[mtu_])
-    , bufCur_(buf_)
+    , batch_(fd, config_.getExt<size_t>("recvBatchDatagrams"), mtu_
+        , config_.getExt<bool>("udpGro"))
+    , pktCount_(0)
+    , pktIndex_(0)
+    , bufCur_(nullptr)
     , bytesRecved_(0) {
         uint32_t yes = 1;
         if (setsockopt(fd, SOL_SOCKET,SO_REUSEADDR, &yes, sizeof(yes)) < 0) {
@@ -112,10 +115,6 @@ struct RecvTransportImpl
         subscriptions_.add(Message::typeTag);
     }
 
-    ~RecvTransportImpl() {
-        delete [] buf_;
-    }
-
 /**
  * @brief start the show by schedule the mesage recv
  */
@@ -155,28 +154,33 @@ private:
                 }
             }
             bytesRecved_ = 0;
-            bufCur_ = buf_;
-            if (isFdReady()) {
-                socklen_t addrLen = sizeof(udpcastListenRemoteAddr);
-                auto l = recvfrom(fd, buf_, mtu_, MSG_NOSIGNAL|MSG_DONTWAIT
-                    , (struct sockaddr *)&udpcastListenRemoteAddr, &addrLen);
-                if (hmbdc_unlikely(l < 0)) {
+            if (pktIndex_ < pktCount_) {
+                bufCur_ = batch_.packet(pktIndex_);
+                bytesRecved_ = batch_.len(pktIndex_);
+                udpcastListenRemoteAddr = batch_.from(pktIndex_);
+                pktIndex_++;
+            } else if (isFdReady()) {
+                auto n = batch_.recv(fd);
+                if (hmbdc_unlikely(n < 0)) {
                     if (!checkErr()) {
                         HMBDC_LOG_C("recvmmsg failed errno=", errno);
                     }
                     return;
-                } else if (l == 0) {
+                } else if (n == 0) {
                     //nothing to do now
                     return;
                 }
-                bytesRecved_ = l;
+                pktCount_ = n;
+                pktIndex_ = 0;
             }
-        } while(bytesRecved_);
+        } while(bytesRecved_ || pktIndex_ < pktCount_);
     }
 
     OutputBuffer& outputBuffer_;
     size_t maxItemSize_;
-    char* buf_;
+    RecvBatch batch_;
+    size_t pktCount_;
+    size_t pktIndex_;
     char* bufCur_;
     size_t bytesRecved_;
     TypeTagSet subscriptions_;
@@ -3,18 +3,25 @@
 
 #include "hmbdc/app/utils/EpollTask.hpp"
 #include "hmbdc/app/Config.hpp"
+#include "hmbdc/app/Logger.hpp"
 #include "hmbdc/comm/inet/Misc.hpp"
 #include "hmbdc/time/Timers.hpp"
 #include "hmbdc/Exception.hpp"
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <netinet/ip.h>
+#include <netinet/udp.h>
 #include <arpa/inet.h>
 
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
+
 namespace hmbdc { namespace tips { namespace udpcast {
 
 using Config = hmbdc::app::Config;
@@ -44,6 +51,82 @@ struct EpollFd : app::utils::EpollFd {
     }
 };
 
+/**
+ * @brief a ring of packet buffers filled by one recvmmsg call
+ * @details with gro on, the kernel may coalesce several same sized packets from the
+ * same sender into one buffer - since every packet only carries whole messages, the
+ * coalesced buffer is parsed the same way as a single packet
+ */
+struct RecvBatch {
+    /**
+     * @brief ctor
+     *
+     * @param fd the udp socket
+     * @param batchSize max packets returned by a recv() call
+     * @param mtu udp payload size of a packet
+     * @param gro try to turn on UDP_GRO on the socket, falls back when not supported
+     */
+    RecvBatch(int fd, size_t batchSize, size_t mtu, bool gro)
+    : batchSize_(std::max(batchSize, size_t(1)))
+    , packetSize_(mtu) {
+        if (gro) {
+            int yes = 1;
+            if (setsockopt(fd, SOL_UDP, UDP_GRO, &yes, sizeof(yes)) < 0) {
+                HMBDC_LOG_W("UDP_GRO not supported, errno=", errno);
+            } else {
+                packetSize_ = 65535u;
+            }
+        }
+        bufs_.resize(batchSize_ * packetSize_);
+        iovs_.resize(batchSize_);
+        froms_.resize(batchSize_);
+        mmsgs_.resize(batchSize_);
+        for (auto i = 0u; i < batchSize_; ++i) {
+            iovs_[i].iov_base = &bufs_[i * packetSize_];
+            iovs_[i].iov_len = packetSize_;
+            auto& h = mmsgs_[i].msg_hdr;
+            h.msg_iov = &iovs_[i];
+            h.msg_iovlen = 1;
+            h.msg_name = &froms_[i];
+        }
+    }
+
+    RecvBatch(RecvBatch const&) = delete;
+    RecvBatch& operator = (RecvBatch const&) = delete;
+
+    /**
+     * @brief read as many packets as available, up to batchSize, without blocking
+     * @return number of packets read, or -1 with errno set
+     */
+    int recv(int fd) {
+        for (auto i = 0u; i < batchSize_; ++i) {
+            mmsgs_[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+        }
+        return recvmmsg(fd, mmsgs_.data(), (unsigned)batchSize_
+            , MSG_NOSIGNAL | MSG_DONTWAIT, nullptr);
+    }
+
+    char* packet(size_t i) {
+        return static_cast<char*>(iovs_[i].iov_base);
+    }
+
+    size_t len(size_t i) const {
+        return mmsgs_[i].msg_len;
+    }
+
+    sockaddr_in const& from(size_t i) const {
+        return froms_[i];
+    }
+
+private:
+    size_t batchSize_;
+    size_t packetSize_;
+    std::vector<char> bufs_;
+    std::vector<iovec> iovs_;
+    std::vector<sockaddr_in> froms_;
+    std::vector<mmsghdr> mmsgs_;
+};
+
 struct Transport : EpollFd {
     using ptr = std::shared_ptr<Transport>;
 
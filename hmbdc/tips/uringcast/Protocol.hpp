@@ -0,0 +1,45 @@
+#include "hmbdc/Copyright.hpp"
+#pragma once
+#include "hmbdc/tips/uringcast/SendTransportEngine.hpp"
+#include "hmbdc/tips/uringcast/RecvTransportEngine.hpp"
+#include "hmbdc/tips/uringcast/DefaultUserConfig.hpp"
+#include "hmbdc/app/utils/NetContextUtil.hpp"
+#include "hmbdc/app/Config.hpp"
+
+#include "hmbdc/pattern/GuardedSingleton.hpp"
+#include <algorithm>
+
+namespace hmbdc { namespace tips { namespace uringcast {
+/**
+ * @brief udpcast compatible datagram protocol whose engines do their IO through io_uring
+ * @details messages go out in batches submitted with one system call, the receive side
+ * keeps a multishot recv over a registered buffer ring - no epoll and usually no
+ * system call per pump iteration. Like udpcast, it is not reliable and does not
+ * carry memory attachments. Needs linux 6.0+.
+ */
+struct Protocol 
+: pattern::GuardedSingleton<Protocol> 
+, private app::utils::NetContextUtil {
+    static constexpr char const* name() { return "uringcast"; }
+    static constexpr auto dftConfig() { return DefaultUserConfig; }
+    using SendTransportEngine = uringcast::SendTransportEngine;
+    template <typename Buffer, typename>
+    using RecvTransportEngine = uringcast::RecvTransportEngine<Buffer>;
+    std::string getTipsDomainName(app::Config cfg) {
+        cfg.resetSection("tx", false);
+        cfg.setAdditionalFallbackConfig(app::Config(DefaultUserConfig));
+
+        auto res = cfg.getExt<std::string>("localDomainName");
+        if (res != "tips-auto") return res;
+        res = cfg.getExt<std::string>("ifaceAddr") + '-' + cfg.getExt<std::string>("udpcastDests");
+        std::replace(res.begin(), res.end(), '/', ':');
+        return res;
+    }
+
+    private:
+    friend pattern::SingletonGuardian<Protocol>;
+    Protocol(){
+        checkEpollTaskInitialization(); //the sockets are udpcast ones
+    }
+};
+}}}
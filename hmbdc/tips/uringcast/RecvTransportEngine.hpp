@@ -0,0 +1,227 @@
+#include "hmbdc/Copyright.hpp"
+#pragma once
+#include "hmbdc/tips/udpcast/Transport.hpp"
+#include "hmbdc/tips/udpcast/Messages.hpp"
+#include "hmbdc/tips/uringcast/DefaultUserConfig.hpp"
+#include "hmbdc/tips/TypeTagSet.hpp"
+#include "hmbdc/app/Client.hpp"
+#include "hmbdc/os/IoUring.hpp"
+#include "hmbdc//MetaUtils.hpp"
+
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace hmbdc { namespace tips { namespace uringcast {
+
+namespace recvtransportengine_detail {
+using Config = hmbdc::app::Config;
+using TransportMessageHeader = udpcast::TransportMessageHeader;
+
+/**
+ * @class RecvTransportImpl<>
+ * @brief impl class
+ * @details a multishot recv stays armed on the socket, the kernel puts each packet
+ * in one of the registered packet buffers and posts a completion - no system
+ * call is needed to pick them up, unless the kernel asks for one to finish its work
+ *
+ * @tparam OutputBuffer type of buffer to hold resulting network messages
+ */
+template <typename OutputBuffer>
+struct RecvTransportImpl
+: udpcast::Transport {
+    RecvTransportImpl(Config cfg
+        , OutputBuffer& outputBuffer)
+	: udpcast::Transport((cfg.setAdditionalFallbackConfig(Config{DefaultUserConfig})
+        , cfg.resetSection("rx", false)))
+    , outputBuffer_(outputBuffer)
+    , maxItemSize_(outputBuffer.maxItemSize())
+    , packetSize_(mtu_)
+    , armed_(false)
+    , ring_(8) {
+        uint32_t yes = 1;
+        if (setsockopt(fd, SOL_SOCKET,SO_REUSEADDR, &yes, sizeof(yes)) < 0) {
+            HMBDC_LOG_C("failed to set reuse address errno=", errno);
+        }
+        auto sz = config_.getExt<int>("udpRecvBufferBytes");
+        if (sz) {
+            if (setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &sz, sizeof(sz)) < 0) {
+                HMBDC_LOG_C("failed to set send buffer size=", sz);
+            }
+        }
+        if (config_.getExt<bool>("udpGro")) {
+            if (setsockopt(fd, SOL_UDP, UDP_GRO, &yes, sizeof(yes)) < 0) {
+                HMBDC_LOG_W("UDP_GRO not supported, errno=", errno);
+            } else {
+                packetSize_ = 65535u;
+            }
+        }
+
+        auto udpcastListenPort = config_.getExt<uint16_t>("udpcastListenPort");
+        struct sockaddr_in udpcastListenAddrPort;
+        memset(&udpcastListenAddrPort, 0, sizeof(udpcastListenAddrPort));
+        udpcastListenAddrPort.sin_family = AF_INET;
+        auto ipStr = cfg.getExt<std::string>("udpcastListenAddr") == std::string("ifaceAddr")
+            ? comm::inet::getLocalIpMatchMask(cfg.getExt<std::string>("ifaceAddr")).first
+            :cfg.getExt<std::string>("udpcastListenAddr");
+        udpcastListenAddrPort.sin_addr.s_addr = inet_addr(ipStr.c_str());
+        udpcastListenAddrPort.sin_port = htons(udpcastListenPort);
+        if (::bind(fd, (struct sockaddr *)&udpcastListenAddrPort, sizeof(udpcastListenAddrPort)) < 0) {
+            HMBDC_THROW(std::runtime_error, "failed to bind udpcast listen address "
+                << ipStr << ':' << cfg.getExt<short>("udpcastListenPort") << " errno=" << errno);
+        }
+
+        uint32_t tmp = sizeof(udpcastListenAddrPort);
+        if (udpcastListenPort == 0
+            && getsockname(fd, (struct sockaddr *)&udpcastListenAddrPort, &tmp)) {
+            HMBDC_THROW(std::runtime_error, "failed getsockname for udpcast listen address "
+                << ipStr << ':' << cfg.getExt<short>("udpcastListenPort") << " errno=" << errno);
+        }
+
+        if ((udpcastListenAddrPort.sin_addr.s_addr & 0x000000F0) == 0xE0) {//multicast address
+            /* use setsockopt() to request that the kernel join a multicast group */
+            struct ip_mreq mreq;
+            mreq.imr_multiaddr.s_addr = udpcastListenAddrPort.sin_addr.s_addr;
+            auto iface =
+                comm::inet::getLocalIpMatchMask(config_.getExt<std::string>("ifaceAddr")).first;
+            mreq.imr_interface.s_addr=inet_addr(iface.c_str());
+            if (setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
+                HMBDC_THROW(std::runtime_error, "failed to join " << ipStr << ":"
+                    << udpcastListenPort << " errno=" << errno);
+            }
+        }
+        listenAddr_ = ipStr;
+        listenPort_ = ntohs(udpcastListenAddrPort.sin_port);
+        HMBDC_LOG_N("listen at ", listenAddr_+ ":" + std::to_string(listenPort_));
+
+        auto bufCount = 1u << std::min(config_.getExt<unsigned>("recvBufferCountPower2"), 15u);
+        bufs_.resize(size_t(bufCount) * packetSize_);
+        ring_.provideBuffers(0, bufs_.data(), bufCount, (unsigned)packetSize_);
+        start();
+    }
+
+    auto const& listenAddr() const {
+        return listenAddr_;
+    }
+
+    auto listenPort() const {
+        return listenPort_;
+    }
+
+    template <app::MessageTupleC Messages, typename CcNode>
+    void subscribeFor(CcNode const& node, uint16_t mod, uint16_t res) {
+        subscriptions_.markSubsFor<Messages>(node, mod, res, [](uint16_t){});
+    }
+
+    template <app::MessageC Message>
+    void subscribe() {
+        subscriptions_.add(Message::typeTag);
+    }
+
+    size_t sessionsRemainingActive() const {
+        return 0; //not supported
+    }
+
+/**
+ * @brief start the show by arming the multishot recv
+ */
+    void start() {
+        auto sqe = ring_.getSqe();
+        sqe->opcode = IORING_OP_RECV;
+        sqe->fd = fd;
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = 0;
+        armed_ = true;
+    }
+
+    void runOnce() HMBDC_RESTRICT {
+        if (hmbdc_unlikely(!armed_)) start();
+        if (hmbdc_unlikely(ring_.submit() < 0)) {
+            HMBDC_LOG_C("io_uring_enter failed errno=", errno);
+        }
+        ring_.reap([this](io_uring_cqe const& cqe) {
+            if (!(cqe.flags & IORING_CQE_F_MORE)) {
+                armed_ = false; //out of buffers or error - needs a new one
+            }
+            if (hmbdc_likely(cqe.res > 0)) {
+                parse(ring_.buffer(cqe), (size_t)cqe.res);
+            } else if (cqe.res < 0 && cqe.res != -ENOBUFS) {
+                HMBDC_LOG_C("multishot recv failed errno=", -cqe.res);
+            }
+            if (cqe.flags & IORING_CQE_F_BUFFER) {
+                ring_.recycleBuffer(cqe);
+            }
+        });
+    }
+
+private:
+    void parse(char* bufCur, size_t bytesRecved) HMBDC_RESTRICT {
+        while (bytesRecved) {
+            auto h = reinterpret_cast<TransportMessageHeader*>(bufCur);
+            auto wireSize = h->wireSize();
+            if (hmbdc_unlikely(bytesRecved < wireSize)) {
+                break;
+            }
+            if (subscriptions_.check(h->typeTag())) {
+                auto l = std::min<size_t>(maxItemSize_, h->messagePayloadLen());
+                outputBuffer_.put(h->payload(), l);
+            }
+            bytesRecved -= wireSize;
+            bufCur += wireSize;
+        }
+    }
+
+    OutputBuffer& outputBuffer_;
+    size_t maxItemSize_;
+    size_t packetSize_;
+    std::vector<char> bufs_;
+    bool armed_;
+    os::IoUring ring_;
+    TypeTagSet subscriptions_;
+    std::string listenAddr_;
+    uint16_t listenPort_;
+};
+
+template <typename OutputBuffer>
+struct RecvTransportEngineImpl
+: RecvTransportImpl<OutputBuffer>
+, hmbdc::app::Client<RecvTransportEngineImpl<OutputBuffer>> {
+    using RecvTransportImpl<OutputBuffer>::RecvTransportImpl;
+    using RecvTransportImpl<OutputBuffer>::hmbdcName;
+    using RecvTransportImpl<OutputBuffer>::schedSpec;
+
+    void rotate() {
+        RecvTransportEngineImpl::invokedCb(0);
+    }
+
+/**
+ * @brief power the io_uring and other things
+ *
+ */
+    /*virtual*/
+    void invokedCb(size_t) HMBDC_RESTRICT override  {
+        RecvTransportImpl<OutputBuffer>::runOnce();
+    }
+
+    using udpcast::Transport::hmbdcName;
+/**
+ * @brief should not happen ever unless an exception thrown
+ *
+ * @param e exception thown
+ */
+    /*virtual*/
+    void stoppedCb(std::exception const& e) override {
+        HMBDC_LOG_C(e.what());
+    };
+};
+
+} //recvtransportengine_detail
+
+template <typename OutputBuffer>
+using RecvTransportImpl = recvtransportengine_detail::RecvTransportImpl<OutputBuffer>;
+
+template <typename OutputBuffer>
+using RecvTransportEngine = recvtransportengine_detail::RecvTransportEngineImpl<OutputBuffer>;
+
+}}}
@@ -0,0 +1,348 @@
+#include "hmbdc/Copyright.hpp"
+#pragma once
+#include "hmbdc/tips/udpcast/Transport.hpp"
+#include "hmbdc/tips/udpcast/Messages.hpp"
+#include "hmbdc/tips/uringcast/DefaultUserConfig.hpp"
+#include "hmbdc/app/Client.hpp"
+#include "hmbdc/comm/inet/Endpoint.hpp"
+#include "hmbdc/pattern/MonoLockFreeBuffer.hpp"
+#include "hmbdc/os/IoUring.hpp"
+#include "hmbdc/time/Time.hpp"
+#include "hmbdc/time/Rater.hpp"
+#include "hmbdc/numeric/BitMath.hpp"
+
+#include <memory>
+#include <optional>
+#include <vector>
+#include <iostream>
+
+namespace hmbdc { namespace tips { namespace uringcast {
+
+using Config = hmbdc::app::Config;
+using TransportMessageHeader = udpcast::TransportMessageHeader;
+
+namespace sendtransportengine_detail {
+HMBDC_CLASS_HAS_DECLARE(hmbdc_net_queued_ts);
+using Buffer = hmbdc::pattern::MonoLockFreeBuffer;
+
+struct SendTransport
+: udpcast::Transport {
+    SendTransport(Config, size_t);
+    ~SendTransport();
+
+    size_t bufferedMessageCount() const {
+        return buffer_.remainingSize();
+    }
+
+    size_t subscribingPartyDetectedCount(uint16_t tag) const {
+        return 0; //not supported
+    }
+
+    size_t sessionsRemainingActive() const {
+        return 0; //not supported
+    }
+
+    template <app::MessageTupleC Messages, typename Node>
+    void advertiseFor(Node const& node, uint16_t mod, uint16_t res) {
+        //only applies to connection oriented transport
+    }
+
+    template <app::MessageC Message>
+    void queue(Message&& msg) {
+        auto n = 1;
+        auto it = buffer_.claim(n);
+        queue(it, std::forward<Message>(msg));
+        buffer_.commit(it, n);
+    }
+
+    template <app::MessageC Message>
+    bool tryQueue(Message&& msg) {
+        auto n = 1;
+        auto it = buffer_.tryClaim(n);
+        if (it) {
+            queue(it, std::forward<Message>(msg));
+            buffer_.commit(it, n);
+            return true;
+        }
+        return false;
+    }
+
+    void queueJustBytes(uint16_t tag, void const* bytes, size_t len
+        , app::hasMemoryAttachment* att) {
+        if (hmbdc_unlikely(att)) {
+            HMBDC_THROW(std::invalid_argument, "uringcast does not carry memory attachments");
+        }
+        if (hmbdc_unlikely(len > maxMessageSize_)) {
+            HMBDC_THROW(std::out_of_range
+                , "maxMessageSize too small to hold a message");
+        }
+        auto it = buffer_.claim();
+        char* addr = static_cast<char*>(*it);
+        auto h = reinterpret_cast<TransportMessageHeader*>(addr);
+        new (addr + sizeof(TransportMessageHeader)) app::MessageWrap<app::JustBytes>(tag, bytes, len, att);
+        h->messagePayloadLen() = sizeof(app::MessageHead) + len;
+        buffer_.commit(it);
+    }
+
+    void runOnce() HMBDC_RESTRICT;
+
+    void stop();
+
+private:
+    size_t maxMessageSize_;
+    typename Buffer::iterator begin_, it_, end_;
+    Buffer buffer_;
+    hmbdc::time::Rater rater_;
+    size_t maxSendBatch_;
+    std::vector<comm::inet::Endpoint> udpcastDests_;
+
+    std::vector<iovec> toSendMsgs_;
+    std::vector<msghdr> toSendPkts_; /// maxSendBatch_ of them for each dest
+    std::vector<bool> destFailed_;
+    size_t inflight_; /// sqes not completed yet, they point into buffer_
+    std::optional<os::IoUring> ring_;
+
+    uint16_t
+    outBufferSizePower2();
+
+    template<typename M, typename ... Messages>
+    void queue(typename Buffer::iterator it, M&& m, Messages&&... msgs) {
+        using Message = typename std::decay<M>::type;
+        static_assert(std::is_trivially_destructible<Message>::value, "cannot send message with dtor");
+        if constexpr (std::is_base_of<app::hasMemoryAttachment, Message>::value) {
+            HMBDC_THROW(std::invalid_argument, "uringcast does not carry memory attachments");
+        }
+        auto s = *it;
+        char* addr = static_cast<char*>(s);
+        auto h = reinterpret_cast<TransportMessageHeader*>(addr);
+        if (hmbdc_likely(sizeof(Message) <= maxMessageSize_)) {
+            new (addr + sizeof(TransportMessageHeader)) app::MessageWrap<Message>(std::forward<M>(m));
+            h->messagePayloadLen() = sizeof(app::MessageWrap<Message>);
+        } else {
+            HMBDC_THROW(std::out_of_range
+                , "maxMessageSize too small to hold a message when constructing SendTransportEngine");
+        }
+        if constexpr (has_hmbdc_net_queued_ts<Message>::value) {
+            h->template wrapped<Message>().hmbdc_net_queued_ts = hmbdc::time::SysTime::now();
+        }
+        queue(++it, std::forward<Messages>(msgs)...);
+    }
+
+    void queue(typename Buffer::iterator it) {}
+    void reap();
+};
+
+struct SendTransportEngine
+: SendTransport
+, hmbdc::app::Client<SendTransportEngine> {
+    using SendTransport::SendTransport;
+    using SendTransport::hmbdcName;
+    using SendTransport::schedSpec;
+
+    void rotate() {
+        SendTransportEngine::invokedCb(0);
+    }
+
+    /*virtual*/
+    void invokedCb(size_t) HMBDC_RESTRICT override  {
+        runOnce();
+    }
+    /*virtual*/ bool droppedCb() override {
+        stop();
+        return true;
+    };
+
+    using udpcast::Transport::hmbdcName;
+};
+
+} //sendtransportengine_detail
+using SendTransport = sendtransportengine_detail::SendTransport;
+using SendTransportEngine = sendtransportengine_detail::SendTransportEngine;
+}}}
+
+
+
+namespace hmbdc { namespace tips { namespace uringcast {
+
+namespace sendtransportengine_detail {
+
+inline
+SendTransport::
+SendTransport(Config cfg
+    , size_t maxMessageSize)
+: udpcast::Transport((cfg.setAdditionalFallbackConfig(Config(DefaultUserConfig))
+    , cfg.resetSection("tx", false)))
+, maxMessageSize_(maxMessageSize)
+, buffer_(maxMessageSize + sizeof(TransportMessageHeader) + sizeof(app::MessageHead), outBufferSizePower2())
+, rater_(hmbdc::time::Duration::seconds(1u)
+    , config_.getExt<size_t>("sendBytesPerSec")
+    , config_.getExt<size_t>("sendBytesBurst")
+    , config_.getExt<size_t>("sendBytesBurst") != 0ul) //no rate control by default
+, maxSendBatch_(config_.getExt<size_t>("maxSendBatch"))
+, toSendMsgs_(maxSendBatch_)
+, inflight_(0) {
+    char loopch = config_.getExt<bool>("loopback")?1:0;
+    if (setsockopt(fd, IPPROTO_IP, IP_MULTICAST_LOOP, (char *)&loopch, sizeof(loopch)) < 0) {
+        HMBDC_THROW(std::runtime_error, "failed to set loopback=" << config_.getExt<bool>("loopback"));
+    }
+
+    auto sz = config_.getExt<int>("udpSendBufferBytes");
+    if (sz) {
+        if (setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &sz, sizeof(sz)) < 0) {
+            HMBDC_LOG_C("failed to set send buffer size=", sz);
+        }
+    }
+
+    auto ttl = config_.getExt<int>("ttl");
+    if (ttl > 0 && setsockopt(fd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl)) < 0) {
+        HMBDC_THROW(std::runtime_error, "failed to set set ttl=" << ttl);
+    }
+
+    auto minHead = sizeof(app::MessageHead) + sizeof(TransportMessageHeader);
+    if (maxMessageSize_ +  minHead > mtu_) {
+        HMBDC_THROW(std::out_of_range, "maxMessageSize=" << maxMessageSize_ << " needs <= " << mtu_ - minHead);
+    }
+    cfg(udpcastDests_, "udpcastDests");
+    if (udpcastDests_.size() == 0) {
+        HMBDC_THROW(std::out_of_range, "empty udpcastDests");
+    }
+    destFailed_.resize(udpcastDests_.size());
+    toSendPkts_.resize(maxSendBatch_ * udpcastDests_.size());
+    memset(toSendPkts_.data(), 0, sizeof(msghdr) * toSendPkts_.size());
+    ring_.emplace((unsigned)toSendPkts_.size());
+    for (auto d = 0u; d < udpcastDests_.size(); ++d) {
+        for (auto p = 0u; p < maxSendBatch_; ++p) {
+            auto& pkt = toSendPkts_[d * maxSendBatch_ + p];
+            pkt.msg_name = &udpcastDests_[d].v;
+            pkt.msg_namelen = sizeof(udpcastDests_[d].v);
+        }
+    }
+}
+
+inline
+SendTransport::
+~SendTransport() {
+    /// the kernel might still be reading from buffer_
+    while (inflight_ && ring_->submit(1) >= 0) {
+        reap();
+    }
+}
+
+inline
+void
+SendTransport::
+stop() {
+    buffer_.reset();
+}
+
+inline
+uint16_t
+SendTransport::
+outBufferSizePower2() {
+    auto res = config_.getExt<uint16_t>("outBufferSizePower2");
+    if (res) {
+        return res;
+    }
+    res =hmbdc::numeric::log2Upper(1024ul * 1024ul / (8ul + maxMessageSize_));
+    HMBDC_LOG_N("auto set --outBufferSizePower2=", res);
+    return res;
+}
+
+inline
+void
+SendTransport::
+reap() {
+    ring_->reap([this](io_uring_cqe const& cqe) {
+        inflight_--;
+        if (hmbdc_unlikely(cqe.res < 0 && cqe.res != -EAGAIN)) {
+            destFailed_[cqe.user_data] = true;
+        }
+    });
+    if (hmbdc_unlikely(!inflight_)) {
+        for (auto d = udpcastDests_.size(); d-- > 0;) {
+            if (hmbdc_unlikely(destFailed_[d])) {
+                HMBDC_LOG_C("unreachable dest=", udpcastDests_[d], " erased");
+                udpcastDests_.erase(udpcastDests_.begin() + d);
+                destFailed_.erase(destFailed_.begin() + d);
+                for (auto i = d; i < udpcastDests_.size(); ++i) {
+                    for (auto p = 0u; p < maxSendBatch_; ++p) {
+                        toSendPkts_[i * maxSendBatch_ + p].msg_name = &udpcastDests_[i].v;
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief one batch of packets in flight at a time - its messages stay in buffer_
+ * till the kernel is done with them. The batch goes out in one io_uring_enter,
+ * UDP sends normally complete right there.
+ */
+inline
+void
+SendTransport::
+runOnce() HMBDC_RESTRICT {
+    if (hmbdc_unlikely(inflight_)) {
+        if (hmbdc_unlikely(ring_->submit() < 0)) {
+            HMBDC_LOG_C("io_uring_enter failed errno=", errno);
+        }
+        reap();
+        if (inflight_) return;
+    }
+    if (it_ == end_) {
+        buffer_.wasteAfterPeek(begin_, end_ - begin_);
+        buffer_.peek(it_, end_, maxSendBatch_);
+        begin_ = it_;
+    }
+    //make packets
+    size_t msgCount = 0;
+    size_t pktCount = 0;
+    size_t pktHead = 0;
+    size_t packetBytes = 0;
+    while (it_ != end_ && msgCount < maxSendBatch_) {
+        void* ptr = *it_;
+        auto item = static_cast<TransportMessageHeader*>(ptr);
+        if (hmbdc_unlikely(!rater_.check(item->wireSize()))) {
+            break;
+        }
+        if (hmbdc_unlikely(packetBytes + item->wireSize() > mtu_)) {
+            toSendPkts_[pktCount].msg_iov = &toSendMsgs_[pktHead];
+            toSendPkts_[pktCount++].msg_iovlen = msgCount - pktHead;
+            pktHead = msgCount;
+            packetBytes = 0;
+        }
+        packetBytes += item->wireSize();
+        toSendMsgs_[msgCount].iov_base = ptr;
+        toSendMsgs_[msgCount++].iov_len = item->wireSize();
+        rater_.commit();
+        it_++;
+    }
+    if (packetBytes) {
+        //wrap up current packet
+        toSendPkts_[pktCount].msg_iov = &toSendMsgs_[pktHead];
+        toSendPkts_[pktCount++].msg_iovlen = msgCount - pktHead;
+    }
+    if (!pktCount) return;
+
+    for (auto d = 0u; d < udpcastDests_.size(); ++d) {
+        for (auto p = 0u; p < pktCount; ++p) {
+            auto& pkt = toSendPkts_[d * maxSendBatch_ + p];
+            pkt.msg_iov = toSendPkts_[p].msg_iov;
+            pkt.msg_iovlen = toSendPkts_[p].msg_iovlen;
+            auto sqe = ring_->getSqe(); //never full - sized for a whole batch
+            sqe->opcode = IORING_OP_SENDMSG;
+            sqe->fd = fd;
+            sqe->addr = (uint64_t)&pkt;
+            sqe->msg_flags = MSG_NOSIGNAL;
+            sqe->user_data = d;
+            inflight_++;
+        }
+    }
+    if (hmbdc_unlikely(ring_->submit() < 0)) {
+        HMBDC_LOG_C("io_uring_enter failed errno=", errno);
+    }
+    reap();
+}
+} //sendtransportengine_detail
+}}}
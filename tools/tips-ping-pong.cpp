@@ -1,5 +1,6 @@
 #include "hmbdc/tips/tcpcast/Protocol.hpp"
 #include "hmbdc/tips/rmcast/Protocol.hpp"
+#include "hmbdc/tips/uringcast/Protocol.hpp"
 
 #include "hmbdc/tips/SingleNodeDomain.hpp"
 #include "hmbdc/tips/Tips.hpp"
@@ -482,7 +483,7 @@ main(int argc, char** argv) {
     ;
     desc.add_options()
     ("help", helpStr)
-    ("netprot,n", po::value<string>(&netprot)->default_value("tcpcast"), "tcpcast, rmcast or nonet(localhost)")
+    ("netprot,n", po::value<string>(&netprot)->default_value("tcpcast"), "tcpcast, rmcast, uringcast or nonet(localhost)")
     ("role,r", po::value<string>(&role)->default_value("pong"), "ping (sender process), pong (echoer process) or both (sender and echoer in the same process")
     ("use0cpy", po::value<bool>(&use0cpy)->default_value(true), "use 0cpy IPC for intra-host communications when msgSize > 1000B")
     ("msgSize", po::value<uint32_t>(&msgSize)->default_value(16), "msg size in bytes, 16B-100MB - the limit is specific to the test, hmbdc does not put limits")
@@ -581,6 +582,9 @@ main(int argc, char** argv) {
     } else if (netprot == "rmcast") {
         config.put("ifaceAddr", netIface);
         return run((rmcast::Protocol*)nullptr);
+    } else if (netprot == "uringcast") {
+        config.put("ifaceAddr", netIface);
+        return run((uringcast::Protocol*)nullptr);
 
     } else if (netprot == "nonet") {
         return run((nonet::Protocol*)nullptr);